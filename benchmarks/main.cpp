@@ -0,0 +1,284 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Crozet.hpp>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace
+{
+	constexpr uint32_t outputFrequency = 48000;
+	constexpr uint16_t outputChannelCount = 2;
+	constexpr uint64_t blockFrameCount = 1024;
+
+	class Timer
+	{
+		public:
+
+			Timer() : _start(std::chrono::steady_clock::now()) {}
+
+			double getElapsedTime() const
+			{
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+			}
+
+		private:
+
+			std::chrono::steady_clock::time_point _start;
+	};
+
+	std::vector<int32_t> createNoise(uint64_t sampleCount)
+	{
+		std::mt19937 generator(0);
+		std::uniform_int_distribution<int32_t> distribution(INT32_MIN / 8, INT32_MAX / 8);
+
+		std::vector<int32_t> samples(sampleCount);
+		for (int32_t& sample : samples)
+		{
+			sample = distribution(generator);
+		}
+
+		return samples;
+	}
+
+	// Each benchmark appends one JSON object to the results. The frame count is the one of the produced signal, which
+	// gives the realtime factor, the mixer also reports the frames of all its voices
+
+	std::vector<std::string> results;
+
+	void addResult(const std::string& benchmark, const std::string& parameters, double time, double frameCount, double byteCount = 0.0, double voiceFrameCount = 0.0)
+	{
+		std::ostringstream stream;
+		stream << "{\"benchmark\": \"" << benchmark << "\", " << parameters << (parameters.empty() ? "" : ", ");
+		stream << "\"time\": " << time << ", \"framesPerSecond\": " << frameCount / time;
+		stream << ", \"realtimeFactor\": " << frameCount / time / outputFrequency;
+		if (byteCount != 0.0)
+		{
+			stream << ", \"megabytesPerSecond\": " << byteCount / time / 1e6;
+		}
+		if (voiceFrameCount != 0.0)
+		{
+			stream << ", \"voiceFramesPerSecond\": " << voiceFrameCount / time;
+		}
+		stream << "}";
+
+		results.push_back(stream.str());
+	}
+
+	void benchmarkMixer()
+	{
+		// Mix an increasing number of voices on a headless output
+
+		constexpr uint64_t soundLength = 10 * outputFrequency;
+		constexpr uint64_t renderedFrames = 5 * outputFrequency;
+
+		const std::vector<int32_t> noise = createNoise(soundLength * outputChannelCount);
+		std::vector<int32_t> output(blockFrameCount * outputChannelCount);
+
+		for (uint64_t voiceCount : { 1, 4, 16, 64, 256 })
+		{
+			crz::AudioOutput audioOutput(outputFrequency, outputChannelCount);
+			for (uint64_t i = 0; i < voiceCount; ++i)
+			{
+				const uint64_t soundId = audioOutput.createSound<crz::SoundBuffer>(outputFrequency, outputChannelCount, soundLength, noise.data());
+				audioOutput.scheduleSound(soundId);
+			}
+
+			Timer timer;
+			for (uint64_t i = 0; i < renderedFrames; i += blockFrameCount)
+			{
+				audioOutput.render(output.data(), blockFrameCount);
+			}
+			const double time = timer.getElapsedTime();
+
+			addResult("mixer", "\"voiceCount\": " + std::to_string(voiceCount), time, renderedFrames, 0.0, renderedFrames * voiceCount);
+		}
+	}
+
+	void benchmarkConversion()
+	{
+		// Pull a sound through SoundSource::getSamples with different frequency and channel count pairs
+
+		constexpr uint64_t renderedFrames = 20 * outputFrequency;
+
+		struct Conversion
+		{
+			uint32_t srcFrequency;
+			uint16_t srcChannelCount;
+			uint32_t dstFrequency;
+			uint16_t dstChannelCount;
+		};
+
+		const Conversion conversions[] = {
+			{ 44100, 2, 48000, 2 },
+			{ 48000, 2, 44100, 2 },
+			{ 22050, 2, 48000, 2 },
+			{ 96000, 2, 48000, 2 },
+			{ 48000, 1, 48000, 2 },
+			{ 48000, 2, 48000, 1 },
+			{ 48000, 6, 48000, 2 },
+			{ 44100, 1, 48000, 2 }
+		};
+
+		for (const Conversion& conversion : conversions)
+		{
+			const uint64_t soundLength = renderedFrames * conversion.srcFrequency / conversion.dstFrequency + 1;
+			const std::vector<int32_t> noise = createNoise(soundLength * conversion.srcChannelCount);
+			std::vector<int32_t> output(blockFrameCount * std::max(conversion.srcChannelCount, conversion.dstChannelCount));
+
+			crz::SoundBuffer sound(conversion.srcFrequency, conversion.srcChannelCount, soundLength, noise.data());
+
+			Timer timer;
+			for (uint64_t i = 0; i + blockFrameCount <= renderedFrames; i += blockFrameCount)
+			{
+				sound.getSamples(conversion.dstFrequency, conversion.dstChannelCount, output.data(), i, i + blockFrameCount);
+			}
+			const double time = timer.getElapsedTime();
+
+			std::ostringstream parameters;
+			parameters << "\"srcFrequency\": " << conversion.srcFrequency << ", \"srcChannelCount\": " << conversion.srcChannelCount;
+			parameters << ", \"dstFrequency\": " << conversion.dstFrequency << ", \"dstChannelCount\": " << conversion.dstChannelCount;
+			addResult("conversion", parameters.str(), time, renderedFrames);
+		}
+	}
+
+	void writeWaveFile(const std::filesystem::path& path, uint32_t frequency, uint16_t channelCount, uint16_t bitsPerSample, uint64_t frameCount)
+	{
+		const auto write = [](std::ofstream& stream, uint64_t value, uint64_t size)
+		{
+			for (uint64_t i = 0; i < size; ++i)
+			{
+				stream.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+			}
+		};
+
+		const uint16_t blockAlign = channelCount * bitsPerSample / 8;
+		const uint32_t dataSize = frameCount * blockAlign;
+
+		std::ofstream stream(path, std::ios::binary);
+		stream.write("RIFF", 4);
+		write(stream, 36 + dataSize, 4);
+		stream.write("WAVEfmt ", 8);
+		write(stream, 16, 4);
+		write(stream, 1, 2);
+		write(stream, channelCount, 2);
+		write(stream, frequency, 4);
+		write(stream, frequency * blockAlign, 4);
+		write(stream, blockAlign, 2);
+		write(stream, bitsPerSample, 2);
+		stream.write("data", 4);
+		write(stream, dataSize, 4);
+
+		std::mt19937 generator(0);
+		std::vector<char> data(dataSize);
+		for (char& byte : data)
+		{
+			byte = static_cast<char>(generator());
+		}
+		stream.write(data.data(), data.size());
+	}
+
+	void benchmarkWaveDecoding()
+	{
+		// Decode WAV files of different sample sizes through SoundFile
+
+		constexpr uint64_t frameCount = 30 * outputFrequency;
+
+		for (uint16_t bitsPerSample : { 16, 24, 32 })
+		{
+			const std::filesystem::path path = std::filesystem::temp_directory_path() / "crozet-bench.wav";
+			writeWaveFile(path, outputFrequency, outputChannelCount, bitsPerSample, frameCount);
+
+			std::vector<int32_t> output(blockFrameCount * outputChannelCount);
+			double time;
+
+			{
+				crz::SoundFile sound(path, crz::SoundFileFormat::Wave);
+
+				Timer timer;
+				for (uint64_t i = 0; i + blockFrameCount <= frameCount; i += blockFrameCount)
+				{
+					sound.getSamples(outputFrequency, outputChannelCount, output.data(), i, i + blockFrameCount);
+				}
+				time = timer.getElapsedTime();
+			}
+
+			std::filesystem::remove(path);
+
+			addResult("waveDecoding", "\"bitsPerSample\": " + std::to_string(bitsPerSample), time, frameCount, frameCount * outputChannelCount * bitsPerSample / 8);
+		}
+	}
+
+	void benchmarkFilterChain()
+	{
+		// Pull a sound through chains of filters of increasing length
+
+		constexpr uint64_t renderedFrames = 20 * outputFrequency;
+
+		const std::vector<int32_t> noise = createNoise(renderedFrames * outputChannelCount);
+		std::vector<int32_t> output(blockFrameCount * outputChannelCount);
+
+		for (uint64_t filterCount : { 0, 1, 4, 16 })
+		{
+			crz::SoundBuffer sound(outputFrequency, outputChannelCount, renderedFrames, noise.data());
+			for (uint64_t i = 0; i < filterCount; ++i)
+			{
+				if (i % 2 == 0)
+				{
+					sound.addFilter<crz::FilterEnvelope>(0.5, 0.5, 0.8, 1.0);
+				}
+				else
+				{
+					sound.addFilter<crz::FilterPlaySpeed>(1.0);
+				}
+			}
+
+			crz::SoundSource* source = sound.getFilteredSource();
+
+			Timer timer;
+			for (uint64_t i = 0; i + blockFrameCount <= renderedFrames; i += blockFrameCount)
+			{
+				source->getSamples(outputFrequency, outputChannelCount, output.data(), i, i + blockFrameCount);
+			}
+			const double time = timer.getElapsedTime();
+
+			addResult("filterChain", "\"filterCount\": " + std::to_string(filterCount), time, renderedFrames);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Results are written as JSON on the standard output, or in the file given as first argument
+
+	benchmarkMixer();
+	benchmarkConversion();
+	benchmarkWaveDecoding();
+	benchmarkFilterChain();
+
+	std::ostringstream json;
+	json << "{\n\t\"frequency\": " << outputFrequency << ",\n\t\"channelCount\": " << outputChannelCount;
+	json << ",\n\t\"blockFrameCount\": " << blockFrameCount << ",\n\t\"results\": [\n";
+	for (uint64_t i = 0; i < results.size(); ++i)
+	{
+		json << "\t\t" << results[i] << (i + 1 == results.size() ? "\n" : ",\n");
+	}
+	json << "\t]\n}\n";
+
+	if (argc > 1)
+	{
+		std::ofstream(argv[1]) << json.str();
+	}
+	else
+	{
+		std::cout << json.str();
+	}
+
+	return 0;
+}
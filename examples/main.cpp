@@ -16,8 +16,6 @@ int main()
 	TODO:
 		- Create a debug manager for
 			- Retrieving PA errors
-			- Retrieving callback CPU load
-			- Retrieve other datas such as frame dropped... status of different streams...
 
 		- Allow for reverse playing / jump back in time
 			- Add bool SoundBase::_reversible
@@ -34,7 +32,13 @@ int main()
 	audioOutput.scheduleSound(0, 4.0, 12.5, 2.5);
 	audioOutput.scheduleSound(1, 7.0, 13.0);
 
-	std::this_thread::sleep_for(std::chrono::seconds(1000));
+	for (uint64_t i = 0; i < 1000; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+
+		const crz::StreamStatistics statistics = audioOutput.getStatistics();
+		std::cout << "CPU load: " << statistics.cpuLoad << " - Silent blocks: " << statistics.silentBlockCount << " - Underflows: " << statistics.outputUnderflowCount << std::endl;
+	}
 
 	return 0;
 }
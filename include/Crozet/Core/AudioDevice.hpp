@@ -11,9 +11,19 @@
 
 namespace crz
 {
+	enum class SampleFormat
+	{
+		Int16,
+		Int24,
+		Int32,
+		Float32
+	};
+
 	struct CRZ_API AudioDevice
 	{
+		int index;
 		std::string name;
+		std::string hostApiName;
 		int maxInputChannels;
 		int maxOutputChannels;
 		double defaultLowInputLatency;
@@ -22,10 +32,20 @@ namespace crz
 		double defaultHighOutputLatency;
 		double defaultSampleRate;
 
+		std::vector<double> inputSampleRates;
+		std::vector<double> outputSampleRates;
+		std::vector<SampleFormat> inputSampleFormats;
+		std::vector<SampleFormat> outputSampleFormats;
+		SampleFormat nativeInputSampleFormat;
+		SampleFormat nativeOutputSampleFormat;
+
 		static int getDefaultInputDeviceIndex();
 		static int getDefaultOutputDeviceIndex();
 
 		static int getDeviceCount();
 		static AudioDevice getAudioDevice(int deviceIndex);
+		static SampleFormat getNativeSampleFormat(int deviceIndex, bool input, uint16_t channelCount, double frequency);
+
+		static bool refreshDevices();
 	};
 }
@@ -8,10 +8,24 @@
 #pragma once
 
 #include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/AudioDevice.hpp>
+#include <Crozet/Core/SampleConverter.hpp>
 #include <Crozet/Core/SoundBase.hpp>
+#include <Crozet/Core/BroadcastRing.hpp>
+#include <Crozet/Core/LockFreeQueue.hpp>
+#include <Crozet/Core/StreamMonitor.hpp>
+#include <Crozet/Core/LoudnessMeter.hpp>
+#include <Crozet/Core/EchoCanceller.hpp>
 
 namespace crz
 {
+	struct CRZ_API VoiceActivityEvent
+	{
+		uint64_t position;
+		bool active;
+		float level;
+	};
+
 	class CRZ_API AudioInput : public SoundBase
 	{
 		public:
@@ -27,24 +41,67 @@ namespace crz
 			void setStoredLength(double storedLength);
 			double getStoredLength() const;
 
+			const BroadcastRing& getRing() const;
+
+			SampleFormat getSampleFormat() const;
+			StreamStatistics getStatistics() const;
+			LoudnessStatistics getLoudnessStatistics() const;
+			void resetLoudnessStatistics();
 			bool isValid() const;
 
+			void setActivityGateEnabled(bool enabled);
+			bool isActivityGateEnabled() const;
+			void setActivityThresholds(float openLevel, float closeLevel);
+			void setActivityHangover(double hangoverTime);
+			bool isActive() const;
+			bool popActivityEvent(VoiceActivityEvent& event);
+
+			void setEchoReference(const AudioOutput* output);
+			const EchoCanceller* getEchoCanceller() const;
+
+			virtual bool isSilent(uint64_t timeFrom, uint64_t timeTo) const override final;
+
 			~AudioInput();
 
 		private:
 
-			int internalCallback(const int32_t* input, unsigned long frameCount);
+			int internalCallback(const void* input, unsigned long frameCount, unsigned long statusFlags);
+			void updateActivity(const int32_t* samples, uint64_t frameCount);
+			void addActivityTransition(uint64_t position, bool active, float level);
+			void replaceEchoCanceller(const AudioOutput* output);
 			virtual void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
 
 			static constexpr uint64_t _frameCount = 1024;
+			static constexpr double _bufferLength = 4.0;
+			static constexpr uint64_t _activityTransitionCount = 64;
+			static constexpr uint64_t _activityEventCapacity = 64;
+			static constexpr uint64_t _echoBlockSize = 256;
 
 			void* _stream;
+			SampleFormat _sampleFormat;
+			SampleConverter _converter;
+
+			uint64_t _storedFrameCount;
+
+			BroadcastRing* _ring;
+			std::vector<int32_t> _deviceSamples;
 
-			uint64_t _storedSamples;
+			StreamMonitor _monitor;
+			LoudnessMeter _loudnessMeter;
+			EchoCanceller* _echoCanceller;
+			const AudioOutput* _echoReference;
 
-			std::mutex _samplesMutex;
-			std::deque<int32_t> _samples;
+			std::atomic<bool> _activityGateEnabled;
+			std::atomic<float> _activityOpenLevel;
+			std::atomic<float> _activityCloseLevel;
+			std::atomic<uint64_t> _activityHangoverFrameCount;
+			bool _active;
+			uint64_t _hangoverFrameCount;
+			std::array<std::atomic<uint64_t>, _activityTransitionCount> _activityTransitions;
+			std::atomic<uint64_t> _activityTransitionTotal;
+			LockFreeQueue<VoiceActivityEvent> _activityEvents;
 
-		friend int audioInputMidCallback(const int32_t* input, unsigned long frameCount, AudioInput* audioInput);
+		friend int audioInputMidCallback(const void* input, unsigned long frameCount, unsigned long statusFlags, AudioInput* audioInput);
+		friend class AudioOutput;
 	};
 }
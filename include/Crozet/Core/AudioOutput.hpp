@@ -8,15 +8,29 @@
 #pragma once
 
 #include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/AudioDevice.hpp>
+#include <Crozet/Core/SampleConverter.hpp>
+#include <Crozet/Core/Automation.hpp>
+#include <Crozet/Core/BroadcastRing.hpp>
+#include <Crozet/Core/LockFreeQueue.hpp>
+#include <Crozet/Core/Spatializer.hpp>
+#include <Crozet/Core/Limiter.hpp>
+#include <Crozet/Core/StreamMonitor.hpp>
+#include <Crozet/Core/LoudnessMeter.hpp>
+#include <Crozet/Core/RealtimeSettings.hpp>
 
 namespace crz
 {
+	template<typename TSound>
+	concept FiniteSound = std::derived_from<TSound, SoundFile> || std::derived_from<TSound, SoundBuffer>;
+
 	class CRZ_API AudioOutput
 	{
 		public:
 
 			AudioOutput();
 			AudioOutput(int deviceIndex);
+			AudioOutput(uint32_t frequency, uint16_t channelCount);
 			AudioOutput(const AudioOutput& output) = delete;
 			AudioOutput(AudioOutput&& output) = delete;
 
@@ -24,24 +38,56 @@ namespace crz
 			AudioOutput& operator=(AudioOutput&& output) = delete;
 
 			template<std::derived_from<SoundBase> TSound, typename... Args> uint64_t createSound(Args&&... args);
+			template<FiniteSound TSound, typename... Args> uint64_t createConvertedSound(Args&&... args);
 			void scheduleSound(uint64_t soundId, double delay = 0.0, double startTime = 0.0, double duration = -1.0, bool removeWhenFinished = true);
+			bool setSoundLoop(uint64_t soundId, double loopStart, double loopEnd, uint64_t repeatCount = UINT64_MAX);
+			void clearSoundLoop(uint64_t soundId);
 			void unscheduleSound(uint64_t soundId);
 			void removeSound(uint64_t soundId);
 
+			void setSoundRouting(uint64_t soundId, const uint16_t* outputChannels, uint16_t channelCount);
+			void setSoundPosition(uint64_t soundId, float x, float y, float z);
+			void clearSoundPosition(uint64_t soundId);
+
+			void setSpatializer(const Spatializer& spatializer);
+			const Spatializer& getSpatializer() const;
+
+			bool setLimiter(float threshold, double lookAhead = 0.005, double release = 0.05);
+			bool removeLimiter();
+			double getLatency() const;
+
+			void setFadeDuration(double fadeDuration);
+			double getFadeDuration() const;
+
+			bool automateSound(uint64_t soundId, VoiceParameter parameter, double time, double value, AutomationCurve curve = AutomationCurve::Linear);
+			bool automateFilter(uint64_t soundId, uint64_t filterId, uint32_t parameter, double time, double value, AutomationCurve curve = AutomationCurve::Linear);
+
 			const SoundBase* getSound(uint64_t soundId) const;
 			SoundBase* getSound(uint64_t soundId);
 
 			uint32_t getFrequency() const;
 			uint16_t getChannelCount() const;
+			SampleFormat getSampleFormat() const;
+			double getCurrentTime() const;
+			StreamStatistics getStatistics() const;
+			LoudnessStatistics getLoudnessStatistics() const;
+			const BroadcastRing& getRing() const;
+			void resetLoudnessStatistics();
 			bool isValid() const;
 
+			RealtimeReport setRealtimeSettings(const RealtimeSettings& settings);
+
+			void render(int32_t* samples, uint64_t frameCount);
+
 			~AudioOutput();
 
 		private:
 
+			void allocateBuffers();
 			bool canScheduleSound(uint64_t soundId, double delay, double startTime, double duration, bool removeWhenFinished) const;
-			int internalCallback(int32_t* output, unsigned long frameCount);
+			int internalCallback(void* output, unsigned long frameCount, unsigned long statusFlags);
 			void samplesComputationLoop();
+			void computeSamples();
 
 			struct ScheduleInfo
 			{
@@ -49,28 +95,136 @@ namespace crz
 				uint64_t timeFrom;
 				uint64_t timeTo;
 				bool removeWhenFinished;
+
+				double position;
+				uint64_t readPosition;
+				std::vector<int32_t> history;
+
+				uint64_t loopStart;
+				uint64_t loopEnd;
+				uint64_t repeatCount;
+				uint64_t crossfadeLength;
+				uint64_t wrapCount;
+				uint64_t loopCacheStart;
+				uint64_t loopCacheEnd;
+				std::vector<int32_t> loopCache;
+			};
+
+			struct AutomationEvent
+			{
+				uint64_t soundId;
+				uint64_t filterId;
+				uint32_t parameter;
+				uint64_t time;
+				float value;
+				AutomationCurve curve;
+			};
+
+			struct VoiceAutomation
+			{
+				AutomationLane gain = AutomationLane(1.f);
+				AutomationLane pan = AutomationLane(0.f);
+				AutomationLane speed = AutomationLane(1.f);
+				std::unordered_map<uint64_t, AutomationLane> filterLanes;
 			};
 
+			struct SpatialGains
+			{
+				std::vector<uint16_t> firstChannels;
+				std::vector<uint16_t> secondChannels;
+				std::vector<float> firstGains;
+				std::vector<float> secondGains;
+			};
+
+			void setLatency(uint64_t latency);
+			uint64_t getScheduleTime(double delay) const;
+			bool isMixingVoices() const;
+			void removeSpatialVoice(uint64_t soundId);
+			void computeSpatialGains(uint64_t voiceFrom, uint64_t voiceCount);
+			void applyAutomationEvents();
+			void addEchoInput(AudioInput* input) const;
+			void removeEchoInput(AudioInput* input) const;
+			uint64_t renderVoice(SoundBase* sound, ScheduleInfo& info, VoiceAutomation* automation, uint64_t time, uint64_t frameCount, uint16_t channelCount, const double*& positions);
+			uint64_t renderVaryingSpeed(SoundSource* source, ScheduleInfo& info, int32_t* samples, const float* speeds, float speed, uint64_t frameCount, uint16_t channelCount, uint64_t timeTo);
+			void readVoiceSamples(SoundSource* source, const ScheduleInfo& info, int32_t* samples, uint64_t timeFrom, uint64_t timeTo, uint16_t channelCount);
+			void crossfadeLoopSeam(const ScheduleInfo& info, int32_t* samples, const double* positions, double firstPosition, uint64_t frameCount, uint16_t channelCount);
+			const float* applyScheduleFades(const ScheduleInfo& info, uint64_t timeFrom, uint64_t frameCount, const double* positions, bool contiguous, const float* gains, float gain);
+			void mixVoice(float* mix, uint64_t frameCount, uint16_t channelCount, const uint16_t* lanes, const float* gains, float gain, const float* pans, float pan);
+			void mixSpatialVoice(float* mix, uint64_t frameCount, uint64_t spatialIndex, const float* gains, float gain);
+
 			static constexpr uint64_t _frameCount = 1024;
+			static constexpr uint64_t _automationQueueCapacity = 4096;
+			static constexpr float _maxSpeed = 16.f;
+			static constexpr double _ringLength = 1.0;
 
 			void* _stream;
+			bool _headless;
 
 			uint32_t _frequency;
 			uint16_t _channelCount;
+			SampleFormat _sampleFormat;
+			SampleConverter _converter;
 
 			uint64_t _nextSoundId;
 			std::unordered_map<uint64_t, SoundBase*> _sounds;
 
 			std::mutex _scheduleMutex;
-			uint64_t _currentTime;
+			std::atomic<uint64_t> _currentTime;
 			std::unordered_map<uint64_t, std::deque<ScheduleInfo>> _schedule;
+			uint64_t _fadeLength;
+
+			std::unordered_map<uint64_t, std::vector<uint16_t>> _routings;
+
+			Spatializer _spatializer;
+			std::unordered_map<uint64_t, uint64_t> _spatialIndices;
+			std::vector<uint64_t> _spatialSoundIds;
+			std::vector<float> _spatialXs;
+			std::vector<float> _spatialYs;
+			std::vector<float> _spatialZs;
+			SpatialGains _spatialGains;
+			SpatialGains _previousSpatialGains;
+
+			Limiter* _limiter;
+			std::atomic<uint64_t> _latency;
+
+			LockFreeQueue<AutomationEvent> _automationEvents;
+			std::unordered_map<uint64_t, VoiceAutomation> _automations;
+
+			std::vector<int32_t> _voiceSamples;
+			std::vector<int32_t> _speedSamples;
+			std::vector<double> _positions;
+			std::vector<float> _speeds;
+			std::vector<float> _gains;
+			std::vector<float> _pans;
+			std::vector<float> _sideGains;
+			std::vector<uint8_t> _panSides;
+			std::vector<float> _fadeGains;
+			std::vector<float> _parameterValues;
+			std::vector<float> _spatialSamples;
+			std::vector<float> _mix;
+
+			StreamMonitor _monitor;
+			LoudnessMeter _loudnessMeter;
+			mutable std::atomic<BroadcastRing*> _ring;
+			mutable std::mutex _ringMutex;
+			mutable std::vector<AudioInput*> _echoInputs;
+			mutable std::mutex _echoMutex;
 
 			std::thread _samplesThread;
 			std::mutex _samplesMutex;
 			std::condition_variable _samplesCondition;
 			std::vector<int32_t> _samples;
+			std::vector<uint8_t> _deviceSamples;
 			bool _samplesReady;
+			uint64_t _renderedFrames;
+
+			RealtimeSettings _realtimeSettings;
+			RealtimeReport _realtimeReport;
+			std::condition_variable _realtimeCondition;
+			bool _realtimeRequested;
+			bool _samplesStopping;
 
-		friend int audioOutputMidCallback(int32_t* output, unsigned long frameCount, AudioOutput* audioOutput);
+		friend int audioOutputMidCallback(void* output, unsigned long frameCount, unsigned long statusFlags, AudioOutput* audioOutput);
+		friend class AudioInput;
 	};
 }
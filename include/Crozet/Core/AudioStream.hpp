@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/AudioDevice.hpp>
+#include <Crozet/Core/SampleConverter.hpp>
+#include <Crozet/Core/SoundBase.hpp>
+#include <Crozet/Core/StreamMonitor.hpp>
+
+namespace crz
+{
+	class CRZ_API AudioStream : public SoundBase
+	{
+		public:
+
+			using ProcessCallback = std::function<void(const int32_t* input, int32_t* output, uint64_t frameCount)>;
+
+			AudioStream(uint64_t frameCount = 128);
+			AudioStream(int inputDeviceIndex, int outputDeviceIndex, uint64_t frameCount = 128);
+			AudioStream(const AudioStream& stream) = delete;
+			AudioStream(AudioStream&& stream) = delete;
+
+			AudioStream& operator=(const AudioStream& stream) = delete;
+			AudioStream& operator=(AudioStream&& stream) = delete;
+
+			void setProcessCallback(const ProcessCallback& callback);
+
+			bool start();
+			void stop();
+			bool isActive() const;
+
+			uint16_t getOutputChannelCount() const;
+			uint64_t getFrameCount() const;
+			SampleFormat getInputSampleFormat() const;
+			SampleFormat getOutputSampleFormat() const;
+			double getLatency() const;
+			StreamStatistics getStatistics() const;
+			bool isValid() const;
+
+			~AudioStream();
+
+		private:
+
+			int internalCallback(const void* input, void* output, unsigned long frameCount, unsigned long statusFlags);
+			virtual void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
+
+			void* _stream;
+
+			uint64_t _frameCount;
+			uint16_t _outputChannelCount;
+			SampleFormat _inputSampleFormat;
+			SampleFormat _outputSampleFormat;
+			SampleConverter _inputConverter;
+			SampleConverter _outputConverter;
+
+			ProcessCallback _processCallback;
+
+			const int32_t* _block;
+			uint64_t _blockTime;
+			std::vector<int32_t> _inputSamples;
+			std::vector<int32_t> _outputSamples;
+
+			StreamMonitor _monitor;
+
+		friend int audioStreamMidCallback(const void* input, void* output, unsigned long frameCount, unsigned long statusFlags, AudioStream* audioStream);
+	};
+}
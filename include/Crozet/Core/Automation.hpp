@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	enum class AutomationCurve
+	{
+		Step,
+		Linear,
+		Exponential
+	};
+
+	enum class VoiceParameter
+	{
+		Gain,
+		Pan,
+		Speed
+	};
+
+	class CRZ_API AutomationLane
+	{
+		public:
+
+			AutomationLane(float defaultValue);
+			AutomationLane(const AutomationLane& lane) = default;
+			AutomationLane(AutomationLane&& lane) = default;
+
+			AutomationLane& operator=(const AutomationLane& lane) = default;
+			AutomationLane& operator=(AutomationLane&& lane) = default;
+
+			void addPoint(uint64_t time, float value, AutomationCurve curve);
+			void discardBefore(uint64_t time);
+			void clear();
+
+			bool render(float* values, uint64_t timeFrom, uint64_t frameCount, float& constantValue) const;
+			float getValue(uint64_t time) const;
+
+			~AutomationLane() = default;
+
+		private:
+
+			struct Point
+			{
+				uint64_t time;
+				float value;
+				AutomationCurve curve;
+			};
+
+			float _defaultValue;
+			std::deque<Point> _points;
+	};
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	struct CRZ_API BroadcastView
+	{
+		uint64_t position;
+		std::array<const int32_t*, 2> samples;
+		std::array<uint64_t, 2> frameCounts;
+
+		uint64_t getFrameCount() const;
+	};
+
+	class CRZ_API BroadcastRing
+	{
+		public:
+
+			BroadcastRing(uint64_t frameCount, uint16_t channelCount);
+			BroadcastRing(const BroadcastRing& ring) = delete;
+			BroadcastRing(BroadcastRing&& ring) = delete;
+
+			BroadcastRing& operator=(const BroadcastRing& ring) = delete;
+			BroadcastRing& operator=(BroadcastRing&& ring) = delete;
+
+			void write(const int32_t* samples, uint64_t frameCount);
+			bool copy(uint64_t position, uint64_t frameCount, int32_t* samples) const;
+
+			uint64_t getWritePosition() const;
+			uint64_t getReadableFrameCount() const;
+			uint64_t getCapacity() const;
+			uint16_t getChannelCount() const;
+
+			~BroadcastRing() = default;
+
+		private:
+
+			bool isIntact(uint64_t position) const;
+
+			uint64_t _mask;
+			uint16_t _channelCount;
+			std::vector<int32_t> _samples;
+
+			alignas(64) std::atomic<uint64_t> _writePosition;
+			alignas(64) std::atomic<uint64_t> _overwritePosition;
+
+		friend class BroadcastReader;
+	};
+
+	class CRZ_API BroadcastReader
+	{
+		public:
+
+			BroadcastReader(const BroadcastRing& ring);
+			BroadcastReader(const BroadcastReader& reader) = delete;
+			BroadcastReader(BroadcastReader&& reader) = delete;
+
+			BroadcastReader& operator=(const BroadcastReader& reader) = delete;
+			BroadcastReader& operator=(BroadcastReader&& reader) = delete;
+
+			BroadcastView acquire(uint64_t maxFrameCount);
+			bool release(const BroadcastView& view);
+
+			uint64_t getAvailableFrameCount() const;
+			uint64_t getPosition() const;
+			uint64_t getSkippedFrameCount() const;
+
+			~BroadcastReader() = default;
+
+		private:
+
+			const BroadcastRing* _ring;
+			uint64_t _position;
+			uint64_t _skippedFrameCount;
+	};
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	enum class Speaker : uint8_t
+	{
+		FrontLeft,
+		FrontRight,
+		FrontCenter,
+		LowFrequency,
+		BackLeft,
+		BackRight,
+		SideLeft,
+		SideRight
+	};
+
+	class CRZ_API ChannelMatrix
+	{
+		public:
+
+			ChannelMatrix();
+			ChannelMatrix(uint16_t inputChannelCount, uint16_t outputChannelCount);
+			ChannelMatrix(uint16_t inputChannelCount, uint16_t outputChannelCount, const float* coefficients);
+			ChannelMatrix(const ChannelMatrix& matrix) = default;
+			ChannelMatrix(ChannelMatrix&& matrix) = default;
+
+			ChannelMatrix& operator=(const ChannelMatrix& matrix) = default;
+			ChannelMatrix& operator=(ChannelMatrix&& matrix) = default;
+
+			static bool getStandardLayout(uint16_t channelCount, const Speaker*& speakers);
+
+			void setCoefficient(uint16_t outputChannel, uint16_t inputChannel, float coefficient);
+			float getCoefficient(uint16_t outputChannel, uint16_t inputChannel) const;
+
+			uint16_t getInputChannelCount() const;
+			uint16_t getOutputChannelCount() const;
+			bool isIdentity() const;
+			bool isSparse() const;
+
+			void apply(int32_t* output, const int32_t* input, uint64_t frameCount) const;
+			void applyResampled(int32_t* output, const int32_t* input, uint64_t inputFrameCount, uint64_t frameCount, uint64_t position, uint64_t step, uint64_t denominator) const;
+
+			~ChannelMatrix() = default;
+
+		private:
+
+			enum class Kind
+			{
+				Identity,
+				Sparse,
+				Dense
+			};
+
+			void addStandardCoefficient(const Speaker* outputSpeakers, Speaker speaker, uint16_t inputChannel, float coefficient);
+			void updateKind();
+
+			uint16_t _inputChannelCount;
+			uint16_t _outputChannelCount;
+			std::vector<float> _coefficients;
+
+			Kind _kind;
+			std::vector<uint16_t> _sources;
+			std::vector<float> _gains;
+	};
+}
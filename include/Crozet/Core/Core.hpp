@@ -17,3 +17,6 @@
 #include <Crozet/Core/templates/AudioOutput.hpp>
 
 #include <Crozet/Core/templates/SoundBase.hpp>
+
+
+#include <Crozet/Core/templates/LockFreeQueue.hpp>
@@ -15,16 +15,39 @@
 
 
 #include <Crozet/Core/AudioDevice.hpp>
+#include <Crozet/Core/SampleConverter.hpp>
 
 #include <Crozet/Core/AudioOutput.hpp>
 #include <Crozet/Core/AudioInput.hpp>
+#include <Crozet/Core/AudioStream.hpp>
 
 
+#include <Crozet/Core/ChannelMatrix.hpp>
 #include <Crozet/Core/SoundSource.hpp>
 
 #include <Crozet/Core/SoundBase.hpp>
 #include <Crozet/Core/SoundFile.hpp>
 #include <Crozet/Core/SoundBuffer.hpp>
+#include <Crozet/Core/SoundStream.hpp>
+#include <Crozet/Core/SoundSequence.hpp>
+#include <Crozet/Core/SoundRecorder.hpp>
 
 #include <Crozet/Core/FilterBase.hpp>
 #include <Crozet/Core/FilterPlaySpeed.hpp>
+#include <Crozet/Core/FilterEnvelope.hpp>
+#include <Crozet/Core/FilterDriftCompensation.hpp>
+
+
+#include <Crozet/Core/LockFreeQueue.hpp>
+#include <Crozet/Core/BroadcastRing.hpp>
+
+#include <Crozet/Core/Automation.hpp>
+#include <Crozet/Core/Spatializer.hpp>
+#include <Crozet/Core/Limiter.hpp>
+
+#include <Crozet/Core/StreamMonitor.hpp>
+#include <Crozet/Core/LoudnessMeter.hpp>
+#include <Crozet/Core/SpectrumAnalyzer.hpp>
+#include <Crozet/Core/EchoCanceller.hpp>
+#include <Crozet/Core/RealtimeSettings.hpp>
+#include <Crozet/Core/Trace.hpp>
@@ -9,10 +9,15 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cstdio>
 #include <condition_variable>
 #include <deque>
 #include <filesystem>
+#include <functional>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -36,17 +41,63 @@ namespace crz
 {
 	struct AudioDevice;
 
+	enum class Dithering;
+	class SampleConverter;
+
 	class AudioOutput;
+	struct VoiceActivityEvent;
 	class AudioInput;
+	class AudioStream;
+
 
+	enum class Speaker : uint8_t;
+	class ChannelMatrix;
 
 	class SoundSource;
 
 	class SoundBase;
 	class SoundFile;
 	class SoundBuffer;
+	class SoundStream;
+	class SoundSequence;
+	class SoundRecorder;
 
 	class FilterBase;
 	class FilterPlaySpeed;
-	// TODO: class FilterEnvelope;
+	class FilterEnvelope;
+	class FilterDriftCompensation;
+
+
+	template<typename TValue> class LockFreeQueue;
+
+	struct BroadcastView;
+	class BroadcastRing;
+	class BroadcastReader;
+
+	class AutomationLane;
+
+	enum class PanningLaw;
+	class Spatializer;
+
+	class Limiter;
+
+	struct RenderTimeHistogram;
+	struct StreamStatistics;
+	class StreamMonitor;
+
+	struct LoudnessStatistics;
+	class LoudnessMeter;
+
+	enum class SpectrumWindow;
+	struct SpectrumFrame;
+	class SpectrumAnalyzer;
+
+	class EchoCanceller;
+
+	enum class ThreadPolicy;
+	struct RealtimeReport;
+	struct RealtimeSettings;
+
+	class Trace;
+	class TraceSpan;
 }
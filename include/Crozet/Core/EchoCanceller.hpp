@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/BroadcastRing.hpp>
+
+namespace crz
+{
+	class CRZ_API EchoCanceller
+	{
+		public:
+
+			EchoCanceller(const BroadcastRing& reference, uint32_t frequency, uint16_t channelCount, double filterLength = 0.128, double maxDelay = 0.25, uint64_t blockSize = 256);
+			EchoCanceller(const EchoCanceller& canceller) = delete;
+			EchoCanceller(EchoCanceller&& canceller) = delete;
+
+			EchoCanceller& operator=(const EchoCanceller& canceller) = delete;
+			EchoCanceller& operator=(EchoCanceller&& canceller) = delete;
+
+			void process(int32_t* samples, uint64_t frameCount);
+			void reset();
+
+			uint32_t getFrequency() const;
+			uint16_t getChannelCount() const;
+			uint64_t getBlockSize() const;
+			uint64_t getFilterFrameCount() const;
+			uint64_t getDelay() const;
+			float getEchoReturnLossEnhancement() const;
+
+			~EchoCanceller();
+
+		private:
+
+			void updateReference(uint64_t frameCount);
+			void readReference(float* output, int64_t endPosition, uint64_t frameCount) const;
+			void processBlock(int32_t* samples, int64_t referencePosition);
+			void estimateDelay(int64_t referencePosition);
+			void clear();
+
+			static constexpr float _stepSize = 0.5f;
+			static constexpr float _powerSmoothing = 0.9f;
+			static constexpr float _phaseSmoothing = 0.7f;
+			static constexpr float _energySmoothing = 0.99f;
+			static constexpr float _minPeakRatio = 8.f;
+			static constexpr double _positionTracking = 0.001;
+
+			BroadcastReader _reader;
+			uint32_t _frequency;
+			uint16_t _channelCount;
+			uint16_t _referenceChannelCount;
+			uint64_t _blockSize;
+			uint64_t _binCount;
+			uint64_t _partitionCount;
+			uint64_t _delaySize;
+
+			void* _fft;
+			void* _delayFft;
+
+			std::vector<float> _referenceHistory;
+			uint64_t _referenceEnd;
+			double _referencePosition;
+			bool _synchronized;
+
+			std::vector<float> _referenceReals;
+			std::vector<float> _referenceImags;
+			uint64_t _referenceHead;
+			std::vector<float> _referencePowers;
+			std::vector<float> _stepSizes;
+			std::vector<float> _weightReals;
+			std::vector<float> _weightImags;
+			uint64_t _constraintPartition;
+
+			std::vector<float> _captureBlock;
+			std::vector<float> _errorBlock;
+			std::vector<float> _timeBlock;
+			std::vector<float> _echoReals;
+			std::vector<float> _echoImags;
+			std::vector<float> _errorReals;
+			std::vector<float> _errorImags;
+			std::vector<float> _fftScratch;
+
+			std::vector<float> _delayCapture;
+			uint64_t _delayCaptureFrameCount;
+			std::vector<float> _delayInput;
+			std::vector<float> _delayCaptureReals;
+			std::vector<float> _delayCaptureImags;
+			std::vector<float> _delayReferenceReals;
+			std::vector<float> _delayReferenceImags;
+			std::vector<float> _crossReals;
+			std::vector<float> _crossImags;
+			std::vector<float> _delayScratch;
+			uint64_t _delay;
+			uint64_t _candidateDelay;
+
+			float _captureEnergy;
+			float _errorEnergy;
+
+			std::atomic<uint64_t> _sharedDelay;
+			std::atomic<float> _echoReturnLossEnhancement;
+			std::atomic<bool> _resetRequested;
+	};
+}
@@ -26,9 +26,13 @@ namespace crz
 			virtual uint16_t getChannelCount() const override = 0;
 			virtual uint64_t getSampleCount() const override = 0;
 			virtual uint64_t getCurrentSample() const override = 0;
+			virtual uint64_t getAvailableSampleCount() const override;
+			virtual bool isSilent(uint64_t timeFrom, uint64_t timeTo) const override;
 
 			void setSource(SoundSource* source);
 
+			virtual void setParameter(uint32_t parameter, const float* values, uint64_t valueCount);
+
 			virtual ~FilterBase() = default;
 
 		protected:
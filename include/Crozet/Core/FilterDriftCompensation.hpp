@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/FilterBase.hpp>
+
+namespace crz
+{
+	class CRZ_API FilterDriftCompensation : public FilterBase
+	{
+		public:
+
+			FilterDriftCompensation(double latency, double maxDeviation = 0.002);
+			FilterDriftCompensation(const FilterDriftCompensation& filter) = delete;
+			FilterDriftCompensation(FilterDriftCompensation&& filter) = delete;
+
+			FilterDriftCompensation& operator=(const FilterDriftCompensation& filter) = delete;
+			FilterDriftCompensation& operator=(FilterDriftCompensation&& filter) = delete;
+
+			void setLatency(double latency);
+			double getLatency() const;
+			double getMeasuredLatency() const;
+			double getRatio() const;
+
+			uint64_t getUnderrunCount() const;
+			uint64_t getResyncCount() const;
+
+			virtual uint32_t getFrequency() const override final;
+			virtual uint16_t getChannelCount() const override final;
+			virtual uint64_t getSampleCount() const override final;
+			virtual uint64_t getCurrentSample() const override final;
+			virtual uint64_t getAvailableSampleCount() const override final;
+			virtual bool isSilent(uint64_t timeFrom, uint64_t timeTo) const override final;
+
+			virtual ~FilterDriftCompensation() = default;
+
+		private:
+
+			uint64_t getSourceFrameCount() const;
+			void resetInterpolation();
+			virtual void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
+
+			static constexpr double _proportionalGain = 0.125;
+			static constexpr double _integralGain = 0.004;
+			static constexpr double _smoothingTime = 1.0;
+
+			std::atomic<double> _latency;
+			double _maxDeviation;
+
+			uint64_t _currentSample;
+			uint64_t _readPosition;
+			bool _primed;
+
+			std::vector<int32_t> _sourceSamples;
+			uint64_t _keptFrameCount;
+			double _phase;
+
+			double _fillEstimate;
+			double _integral;
+			std::atomic<double> _ratio;
+			std::atomic<double> _measuredLatency;
+
+			std::atomic<uint64_t> _underrunCount;
+			std::atomic<uint64_t> _resyncCount;
+	};
+}
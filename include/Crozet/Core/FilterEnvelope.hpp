@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/FilterBase.hpp>
+
+namespace crz
+{
+	class CRZ_API FilterEnvelope : public FilterBase
+	{
+		public:
+
+			enum Parameter : uint32_t
+			{
+				GainParameter
+			};
+
+			FilterEnvelope();
+			FilterEnvelope(double attack, double decay, double sustain, double release);
+			FilterEnvelope(const FilterEnvelope& filter) = delete;
+			FilterEnvelope(FilterEnvelope&& filter) = delete;
+
+			FilterEnvelope& operator=(const FilterEnvelope& filter) = delete;
+			FilterEnvelope& operator=(FilterEnvelope&& filter) = delete;
+
+			void setAdsr(double attack, double decay, double sustain, double release);
+			void setReleaseTime(double releaseTime);
+			void addGainPoint(double time, double gain);
+			void clearGainPoints();
+
+			virtual void setParameter(uint32_t parameter, const float* values, uint64_t valueCount) override final;
+
+			virtual uint32_t getFrequency() const override final;
+			virtual uint16_t getChannelCount() const override final;
+			virtual uint64_t getSampleCount() const override final;
+			virtual uint64_t getCurrentSample() const override final;
+
+			virtual ~FilterEnvelope() = default;
+
+		private:
+
+			struct Breakpoint
+			{
+				uint64_t time;
+				float gain;
+			};
+
+			struct Envelope
+			{
+				double attack;
+				double decay;
+				double sustain;
+				double release;
+				double releaseTime;
+				std::vector<std::pair<double, double>> gainPoints;
+
+				bool breakpointsOutdated;
+				std::vector<Breakpoint> adsrBreakpoints;
+				std::vector<Breakpoint> gainBreakpoints;
+			};
+
+			static bool renderBreakpoints(const std::vector<Breakpoint>& breakpoints, uint64_t timeFrom, uint64_t frameCount, float* gains, float& constantGain);
+
+			void publishEnvelope();
+			void computeBreakpoints(Envelope& envelope);
+			virtual void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
+
+			static constexpr uint8_t _newEnvelope = 4;
+
+			double _attack;
+			double _decay;
+			double _sustain;
+			double _release;
+			double _releaseTime;
+			std::vector<std::pair<double, double>> _gainPoints;
+
+			std::array<Envelope, 3> _envelopes;
+			uint8_t _controlEnvelope;
+			std::atomic<uint8_t> _pendingEnvelope;
+			uint8_t _mixEnvelope;
+			std::vector<float> _adsrGains;
+			std::vector<float> _automationGains;
+			std::vector<float> _parameterGains;
+			std::vector<float> _stretchedGains;
+	};
+}
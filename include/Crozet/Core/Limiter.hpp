@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	class CRZ_API Limiter
+	{
+		public:
+
+			Limiter(uint32_t frequency, uint16_t channelCount, float threshold = -1.f, double lookAhead = 0.005, double release = 0.05);
+			Limiter(const Limiter& limiter) = default;
+			Limiter(Limiter&& limiter) = default;
+
+			Limiter& operator=(const Limiter& limiter) = default;
+			Limiter& operator=(Limiter&& limiter) = default;
+
+			void setThreshold(float threshold);
+			float getThreshold() const;
+			void setRelease(double release);
+			double getRelease() const;
+
+			uint32_t getFrequency() const;
+			uint16_t getChannelCount() const;
+			uint64_t getLatency() const;
+
+			void process(float* mix, uint64_t frameCount);
+			void reset();
+
+			~Limiter() = default;
+
+		private:
+
+			float computeGain(float requiredGain);
+
+			static constexpr uint64_t _chunkFrameCount = 1024;
+
+			uint32_t _frequency;
+			uint16_t _channelCount;
+			float _threshold;
+			double _release;
+			uint64_t _latency;
+
+			float _thresholdSample;
+			float _releaseFactor;
+
+			std::vector<float> _delayedSamples;
+			std::vector<float> _peaks;
+			std::vector<float> _gains;
+
+			std::vector<uint64_t> _windowPositions;
+			std::vector<float> _windowGains;
+			uint64_t _windowBegin;
+			uint64_t _windowEnd;
+			uint64_t _position;
+
+			float _releasedGain;
+			std::vector<float> _smoothedGains;
+			double _gainSum;
+	};
+}
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	template<typename TValue>
+	class LockFreeQueue
+	{
+		public:
+
+			LockFreeQueue(uint64_t capacity);
+			LockFreeQueue(const LockFreeQueue<TValue>& queue) = delete;
+			LockFreeQueue(LockFreeQueue<TValue>&& queue) = delete;
+
+			LockFreeQueue<TValue>& operator=(const LockFreeQueue<TValue>& queue) = delete;
+			LockFreeQueue<TValue>& operator=(LockFreeQueue<TValue>&& queue) = delete;
+
+			bool push(const TValue& value);
+			bool pop(TValue& value);
+
+			uint64_t getCapacity() const;
+
+			~LockFreeQueue();
+
+		private:
+
+			struct Cell
+			{
+				std::atomic<uint64_t> sequence;
+				TValue value;
+			};
+
+			uint64_t _mask;
+			Cell* _cells;
+
+			alignas(64) std::atomic<uint64_t> _pushPosition;
+			alignas(64) std::atomic<uint64_t> _popPosition;
+	};
+}
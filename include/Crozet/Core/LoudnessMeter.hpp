@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	struct CRZ_API LoudnessStatistics
+	{
+		float truePeak;
+		float maxTruePeak;
+		float rmsLevel;
+		float momentaryLoudness;
+		float shortTermLoudness;
+		float integratedLoudness;
+	};
+
+	class CRZ_API LoudnessMeter
+	{
+		public:
+
+			LoudnessMeter();
+			LoudnessMeter(const LoudnessMeter& meter) = delete;
+			LoudnessMeter(LoudnessMeter&& meter) = delete;
+
+			LoudnessMeter& operator=(const LoudnessMeter& meter) = delete;
+			LoudnessMeter& operator=(LoudnessMeter&& meter) = delete;
+
+			void setFormat(uint32_t frequency, uint16_t channelCount);
+
+			void process(const int32_t* samples, uint64_t frameCount);
+			void process(const float* mix, uint64_t frameCount);
+			void reset();
+
+			LoudnessStatistics getStatistics() const;
+
+			~LoudnessMeter() = default;
+
+		private:
+
+			struct SharedStatistics
+			{
+				std::atomic<float> truePeak;
+				std::atomic<float> maxTruePeak;
+				std::atomic<float> rmsLevel;
+				std::atomic<float> momentaryLoudness;
+				std::atomic<float> shortTermLoudness;
+				std::atomic<float> integratedLoudness;
+			};
+
+			template<typename TInput> void processSamples(const TInput* samples, uint64_t frameCount);
+			void processChannel(uint16_t channel, uint64_t frameCount);
+			void completeSubBlock();
+			void clear();
+			void publish(const LoudnessStatistics& statistics);
+
+			static constexpr uint64_t _chunkFrameCount = 1024;
+			static constexpr uint64_t _phaseCount = 4;
+			static constexpr uint64_t _tapCount = 12;
+			static constexpr uint64_t _momentaryBlockCount = 4;
+			static constexpr uint64_t _shortTermBlockCount = 30;
+			static constexpr uint64_t _histogramBinCount = 1000;
+
+			uint32_t _frequency;
+			uint16_t _channelCount;
+			uint64_t _subBlockFrameCount;
+
+			std::vector<float> _channelWeights;
+			std::array<double, 5> _shelfCoefficients;
+			std::array<double, 5> _highPassCoefficients;
+			std::vector<double> _filterStates;
+			std::array<float, _phaseCount * _tapCount> _peakTaps;
+
+			std::vector<float> _channelSamples;
+			std::vector<float> _oversampledSamples;
+
+			uint64_t _subBlockPosition;
+			double _subBlockEnergy;
+			double _subBlockSquares;
+			float _subBlockPeak;
+
+			uint64_t _subBlockCount;
+			std::array<double, _shortTermBlockCount> _energies;
+			std::array<double, _shortTermBlockCount> _squares;
+			std::array<float, _shortTermBlockCount> _peaks;
+			float _maxTruePeak;
+
+			std::vector<uint64_t> _histogramCounts;
+			std::vector<double> _histogramEnergies;
+
+			std::atomic<bool> _resetRequested;
+			std::atomic<uint64_t> _sequence;
+			SharedStatistics _statistics;
+	};
+}
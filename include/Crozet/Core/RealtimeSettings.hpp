@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	enum class ThreadPolicy
+	{
+		Default,
+		Fifo,
+		RoundRobin
+	};
+
+	struct CRZ_API RealtimeReport
+	{
+		ThreadPolicy policy;
+		int32_t priority;
+		std::vector<uint16_t> cpus;
+		bool memoryLocked;
+		uint64_t prefaultedStackSize;
+	};
+
+	struct CRZ_API RealtimeSettings
+	{
+		ThreadPolicy policy = ThreadPolicy::Default;
+		int32_t priority = 0;
+		std::vector<uint16_t> cpus = {};
+		bool lockMemory = false;
+		uint64_t prefaultedStackSize = 0;
+
+		RealtimeReport applyToCurrentThread() const;
+	};
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/AudioDevice.hpp>
+
+namespace crz
+{
+	enum class Dithering
+	{
+		None,
+		Triangular
+	};
+
+	class CRZ_API SampleConverter
+	{
+		public:
+
+			SampleConverter(SampleFormat format = SampleFormat::Int32, Dithering dithering = Dithering::Triangular);
+			SampleConverter(const SampleConverter& converter) = default;
+			SampleConverter(SampleConverter&& converter) = default;
+
+			SampleConverter& operator=(const SampleConverter& converter) = default;
+			SampleConverter& operator=(SampleConverter&& converter) = default;
+
+			static uint64_t getSampleSize(SampleFormat format);
+
+			SampleFormat getFormat() const;
+			uint64_t getSampleSize() const;
+
+			void setDithering(Dithering dithering);
+			Dithering getDithering() const;
+
+			void decode(int32_t* samples, const void* input, uint64_t sampleCount) const;
+			void encode(void* output, const int32_t* samples, uint64_t sampleCount);
+			void encode(void* output, const float* mix, uint64_t sampleCount);
+
+			~SampleConverter() = default;
+
+		private:
+
+			template<typename TInput> void encodeSamples(void* output, const TInput* input, uint64_t sampleCount);
+
+			SampleFormat _format;
+			Dithering _dithering;
+			uint32_t _ditherPosition;
+	};
+}
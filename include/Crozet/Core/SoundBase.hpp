@@ -46,7 +46,7 @@ namespace crz
 
 			uint32_t _frequency;
 			uint16_t _channelCount;
-			uint64_t _sampleCount;
+			std::atomic<uint64_t> _sampleCount;
 			uint64_t _currentSample;
 
 			std::vector<FilterBase*> _filters;
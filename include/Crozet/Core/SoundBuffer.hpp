@@ -17,6 +17,7 @@ namespace crz
 		public:
 
 			SoundBuffer(uint32_t frequency, uint16_t channelCount, uint64_t sampleCount, const int32_t* samples);
+			SoundBuffer(SoundSource& source, uint32_t frequency, uint16_t channelCount);
 			SoundBuffer(const SoundBuffer& sound) = delete;
 			SoundBuffer(SoundBuffer&& sound) = delete;
 
@@ -29,6 +30,9 @@ namespace crz
 
 			void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
 
+			static constexpr uint64_t _conversionFrameCount = 4096;
+
+			std::vector<int32_t> _ownedSamples;
 			const int32_t* _samples;
 	};
 }
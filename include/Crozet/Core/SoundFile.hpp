@@ -8,6 +8,7 @@
 #pragma once
 
 #include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/SampleConverter.hpp>
 #include <Crozet/Core/SoundBase.hpp>
 
 namespace crz
@@ -28,16 +29,24 @@ namespace crz
 			SoundFile& operator=(const SoundFile& sound) = delete;
 			SoundFile& operator=(SoundFile&& sound) = delete;
 
+			SampleFormat getSampleFormat() const;
+			bool isValid() const;
+
 			~SoundFile();
 
 		private:
 
+			bool readWaveHeader();
 			void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
 
+			static constexpr uint64_t _maxChunkFrameCount = 4096;
+
 			SoundFileFormat _format;
 
 			std::FILE* _file;
-			dsk::IStream* _stream;
-			dsk::fmt::FormatIStream* _formatStream;
+			SampleConverter _converter;
+			uint64_t _dataOffset;
+			uint64_t _frameSize;
+			std::vector<uint8_t> _fileSamples;
 	};
 }
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/AudioDevice.hpp>
+#include <Crozet/Core/SampleConverter.hpp>
+#include <Crozet/Core/BroadcastRing.hpp>
+#include <Crozet/Core/RealtimeSettings.hpp>
+
+namespace crz
+{
+	class CRZ_API SoundRecorder
+	{
+		public:
+
+			SoundRecorder(AudioInput& input, const std::filesystem::path& path, SampleFormat format = SampleFormat::Int24, bool directIo = false, uint64_t preallocatedSize = 0);
+			SoundRecorder(const SoundRecorder& recorder) = delete;
+			SoundRecorder(SoundRecorder&& recorder) = delete;
+
+			SoundRecorder& operator=(const SoundRecorder& recorder) = delete;
+			SoundRecorder& operator=(SoundRecorder&& recorder) = delete;
+
+			void stop();
+
+			void setSilenceSkipping(bool enabled);
+			bool isSkippingSilence() const;
+
+			uint32_t getFrequency() const;
+			uint16_t getChannelCount() const;
+			SampleFormat getSampleFormat() const;
+			uint64_t getRecordedFrameCount() const;
+			uint64_t getDroppedFrameCount() const;
+			uint64_t getSilentFrameCount() const;
+			bool isRecording() const;
+			bool isValid() const;
+
+			RealtimeReport setRealtimeSettings(const RealtimeSettings& settings);
+
+			~SoundRecorder();
+
+		private:
+
+			void writingLoop();
+			bool writeHeader();
+
+			static constexpr uint64_t _headerSize = 4096;
+			static constexpr uint64_t _maxChunkFrameCount = 32768;
+
+			AudioInput* _input;
+			const AudioInput* _activitySource;
+			BroadcastReader _reader;
+			void* _file;
+
+			uint32_t _frequency;
+			uint16_t _channelCount;
+			SampleFormat _format;
+			SampleConverter _converter;
+			uint64_t _frameSize;
+
+			std::atomic<uint64_t> _recordedFrameCount;
+			std::atomic<uint64_t> _droppedFrameCount;
+			std::atomic<uint64_t> _silentFrameCount;
+			std::atomic<bool> _silenceSkipping;
+
+			uint64_t _chunkFrameCount;
+			uint8_t* _chunk;
+			uint64_t _dataSize;
+
+			std::atomic<uint64_t> _stopPosition;
+			std::atomic<bool> _failed;
+			std::thread _writingThread;
+
+			RealtimeSettings _realtimeSettings;
+			RealtimeReport _realtimeReport;
+			std::mutex _realtimeMutex;
+			std::condition_variable _realtimeCondition;
+			std::atomic<bool> _realtimeRequested;
+			bool _writing;
+	};
+}
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/SoundBase.hpp>
+#include <Crozet/Core/SoundFile.hpp>
+#include <Crozet/Core/RealtimeSettings.hpp>
+
+namespace crz
+{
+	class CRZ_API SoundSequence : public SoundBase
+	{
+		public:
+
+			SoundSequence(uint32_t frequency, uint16_t channelCount, uint64_t preloadCount = 2, double prefetchLength = 1.0);
+			SoundSequence(const SoundSequence& sound) = delete;
+			SoundSequence(SoundSequence&& sound) = delete;
+
+			SoundSequence& operator=(const SoundSequence& sound) = delete;
+			SoundSequence& operator=(SoundSequence&& sound) = delete;
+
+			uint64_t append(const std::filesystem::path& path, SoundFileFormat format = SoundFileFormat::Wave);
+			void close();
+
+			void setCrossfadeDuration(double duration);
+			double getCrossfadeDuration() const;
+
+			virtual uint64_t getAvailableSampleCount() const override final;
+			uint64_t getEntryCount() const;
+			uint64_t getCurrentEntry() const;
+			uint64_t getPreloadCount() const;
+			bool isClosed() const;
+
+			uint64_t getUnderrunCount() const;
+			uint64_t getUnderrunFrameCount() const;
+
+			RealtimeReport setRealtimeSettings(const RealtimeSettings& settings);
+
+			~SoundSequence();
+
+		private:
+
+			enum class SlotState : uint8_t
+			{
+				Free,
+				Ready,
+				Done
+			};
+
+			struct Slot
+			{
+				SoundFile* file;
+				uint64_t entry;
+				uint64_t frameCount;
+				uint64_t decodedFrameCount;
+				std::vector<int32_t> ring;
+
+				alignas(64) std::atomic<uint64_t> writePosition;
+				alignas(64) std::atomic<uint64_t> readPosition;
+				std::atomic<SlotState> state;
+			};
+
+			void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
+			uint64_t readFrames(int32_t* samples, uint64_t frameCount);
+			uint64_t readSlot(Slot& slot, int32_t* samples, uint64_t frameCount);
+			void finishEntry();
+			bool hasEnded() const;
+
+			void loadingLoop();
+			bool openEntries();
+			bool decodeEntries();
+
+			static constexpr uint64_t _openSampleCount = uint64_t(1) << 40;
+			static constexpr uint64_t _maxChunkFrameCount = 4096;
+			static constexpr uint64_t _undecidedFade = UINT64_MAX;
+
+			std::vector<Slot> _slots;
+			uint64_t _mask;
+
+			std::vector<std::pair<std::filesystem::path, SoundFileFormat>> _entries;
+			std::mutex _entryMutex;
+			std::atomic<uint64_t> _entryCount;
+			std::atomic<uint64_t> _openedEntryCount;
+			std::atomic<uint64_t> _openedSlotCount;
+			std::atomic<bool> _closed;
+
+			std::mutex _loadingMutex;
+			std::condition_variable _loadingCondition;
+			std::atomic<bool> _loaderWaiting;
+			std::atomic<bool> _stopping;
+			std::thread _loadingThread;
+
+			RealtimeSettings _realtimeSettings;
+			RealtimeReport _realtimeReport;
+			std::mutex _realtimeMutex;
+			std::condition_variable _realtimeCondition;
+			std::atomic<bool> _realtimeRequested;
+
+			std::atomic<uint64_t> _crossfadeLength;
+			std::atomic<uint64_t> _playingSlot;
+			std::atomic<uint64_t> _playingEntry;
+			uint64_t _playedFrameCount;
+			uint64_t _nextPlayedFrameCount;
+			uint64_t _fadeFrameCount;
+			std::vector<int32_t> _fadeSamples;
+
+			uint64_t _readTime;
+			std::atomic<uint64_t> _underrunCount;
+			std::atomic<uint64_t> _underrunFrameCount;
+	};
+}
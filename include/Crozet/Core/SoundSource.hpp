@@ -8,6 +8,7 @@
 #pragma once
 
 #include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/ChannelMatrix.hpp>
 
 namespace crz
 {
@@ -25,17 +26,34 @@ namespace crz
 			virtual uint16_t getChannelCount() const = 0;
 			virtual uint64_t getSampleCount() const = 0;
 			virtual uint64_t getCurrentSample() const = 0;
+			virtual uint64_t getAvailableSampleCount() const;
+			virtual bool isSilent(uint64_t timeFrom, uint64_t timeTo) const;
 
 			double getCurrentTime() const;
 
+			void setChannelMatrix(const ChannelMatrix& matrix);
+
 			void getSamples(uint32_t frequency, uint16_t channelCount, int32_t* samples, uint64_t timeFrom, uint64_t timeTo);
 
 			virtual ~SoundSource() = default;
 
 		protected:
 
-			SoundSource() = default;
+			SoundSource();
 
 			virtual void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) = 0;
+
+		private:
+
+			void readSamples(uint32_t frequency, uint16_t channelCount, int32_t* samples, uint64_t timeFrom, uint64_t timeTo);
+
+			ChannelMatrix _channelMatrix;
+
+			std::vector<int32_t> _rawSamples;
+			std::vector<int32_t> _rawHistory;
+			uint64_t _rawHistoryEnd;
+			uint64_t _rawHistoryCount;
+			uint64_t _resampledTime;
+			std::atomic<bool> _reading;
 	};
 }
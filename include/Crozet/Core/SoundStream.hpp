@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/SoundBase.hpp>
+
+namespace crz
+{
+	class CRZ_API SoundStream : public SoundBase
+	{
+		public:
+
+			SoundStream(uint32_t frequency, uint16_t channelCount, double bufferLength = 1.0);
+			SoundStream(const SoundStream& sound) = delete;
+			SoundStream(SoundStream&& sound) = delete;
+
+			SoundStream& operator=(const SoundStream& sound) = delete;
+			SoundStream& operator=(SoundStream&& sound) = delete;
+
+			void setWatermarks(double lowWatermark, double highWatermark);
+			double getLowWatermark() const;
+			double getHighWatermark() const;
+
+			uint64_t push(const int32_t* samples, uint64_t frameCount, bool blocking = true);
+			void close();
+
+			virtual uint64_t getAvailableSampleCount() const override final;
+			uint64_t getBufferedFrameCount() const;
+			uint64_t getCapacity() const;
+			bool isBelowLowWatermark() const;
+			bool isClosed() const;
+
+			uint64_t getUnderrunCount() const;
+			uint64_t getUnderrunFrameCount() const;
+
+			~SoundStream();
+
+		private:
+
+			void getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo) override final;
+
+			static constexpr uint64_t _openSampleCount = uint64_t(1) << 40;
+
+			std::vector<int32_t> _ring;
+			uint64_t _mask;
+			uint64_t _lowWatermark;
+			uint64_t _highWatermark;
+
+			alignas(64) std::atomic<uint64_t> _writePosition;
+			alignas(64) std::atomic<uint64_t> _readPosition;
+			std::mutex _producerMutex;
+			std::condition_variable _producerCondition;
+			std::atomic<bool> _producerWaiting;
+			std::atomic<bool> _closed;
+
+			uint64_t _readTime;
+			std::atomic<uint64_t> _underrunCount;
+			std::atomic<uint64_t> _underrunFrameCount;
+	};
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	enum class PanningLaw
+	{
+		ConstantPower,
+		Vbap
+	};
+
+	class CRZ_API Spatializer
+	{
+		public:
+
+			Spatializer(uint16_t channelCount = 2);
+			Spatializer(const Spatializer& spatializer) = default;
+			Spatializer(Spatializer&& spatializer) = default;
+
+			Spatializer& operator=(const Spatializer& spatializer) = default;
+			Spatializer& operator=(Spatializer&& spatializer) = default;
+
+			void setSpeakerAzimuth(uint16_t channel, float azimuth);
+			void removeSpeaker(uint16_t channel);
+			float getSpeakerAzimuth(uint16_t channel) const;
+
+			void setPanningLaw(PanningLaw panningLaw);
+			PanningLaw getPanningLaw() const;
+
+			void setDistanceModel(float referenceDistance, float maxDistance, float rolloffFactor);
+			void setListener(float x, float y, float z, float yaw);
+
+			uint16_t getChannelCount() const;
+
+			void computeGains(const float* xs, const float* ys, const float* zs, uint64_t voiceCount, uint16_t* firstChannels, uint16_t* secondChannels, float* firstGains, float* secondGains) const;
+
+			~Spatializer() = default;
+
+		private:
+
+			struct SpeakerPair
+			{
+				float azimuth;
+				float span;
+				uint16_t firstChannel;
+				uint16_t secondChannel;
+				bool invertible;
+				std::array<float, 4> inverseBase;
+			};
+
+			void computePairs();
+
+			uint16_t _channelCount;
+			std::vector<float> _azimuths;
+			PanningLaw _panningLaw;
+
+			float _referenceDistance;
+			float _maxDistance;
+			float _rolloffFactor;
+
+			float _listenerX;
+			float _listenerY;
+			float _listenerZ;
+			float _listenerYaw;
+
+			std::vector<SpeakerPair> _pairs;
+			bool _frontOnly;
+			float _minAzimuth;
+			float _maxAzimuth;
+	};
+}
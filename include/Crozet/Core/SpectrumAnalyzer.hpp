@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/BroadcastRing.hpp>
+
+namespace crz
+{
+	enum class SpectrumWindow
+	{
+		Rectangular,
+		Hann,
+		BlackmanHarris
+	};
+
+	struct CRZ_API SpectrumFrame
+	{
+		uint64_t position;
+		uint16_t channelCount;
+		uint64_t binCount;
+		std::vector<float> magnitudes;
+
+		float getMagnitude(uint16_t channel, uint64_t bin) const;
+	};
+
+	class CRZ_API SpectrumAnalyzer
+	{
+		public:
+
+			SpectrumAnalyzer(const BroadcastRing& ring, uint32_t frequency, uint64_t frameSize = 2048, uint64_t hopSize = 512, SpectrumWindow window = SpectrumWindow::Hann);
+			SpectrumAnalyzer(const SpectrumAnalyzer& analyzer) = delete;
+			SpectrumAnalyzer(SpectrumAnalyzer&& analyzer) = delete;
+
+			SpectrumAnalyzer& operator=(const SpectrumAnalyzer& analyzer) = delete;
+			SpectrumAnalyzer& operator=(SpectrumAnalyzer&& analyzer) = delete;
+
+			bool popFrame(SpectrumFrame& frame);
+			bool getLatestFrame(SpectrumFrame& frame) const;
+
+			uint32_t getFrequency() const;
+			uint64_t getFrameSize() const;
+			uint64_t getHopSize() const;
+			uint64_t getBinCount() const;
+			float getBinFrequency(uint64_t bin) const;
+			uint64_t getDroppedFrameCount() const;
+
+			~SpectrumAnalyzer();
+
+		private:
+
+			void analysisLoop();
+			void analyze(uint64_t position);
+
+			static constexpr uint64_t _maxPendingFrameCount = 64;
+
+			BroadcastReader _reader;
+			uint32_t _frequency;
+			uint16_t _channelCount;
+			uint64_t _frameSize;
+			uint64_t _hopSize;
+
+			void* _fft;
+			std::vector<float> _window;
+			float _magnitudeScale;
+
+			std::vector<int32_t> _hopSamples;
+			uint64_t _hopFrameCount;
+			std::vector<float> _history;
+			uint64_t _historyFrameCount;
+			std::vector<float> _windowedSamples;
+			std::vector<float> _spectrumReals;
+			std::vector<float> _spectrumImags;
+			std::vector<float> _fftScratch;
+
+			mutable std::mutex _framesMutex;
+			std::deque<SpectrumFrame> _frames;
+			SpectrumFrame _latestFrame;
+			uint64_t _droppedFrameCount;
+
+			std::atomic<bool> _running;
+			std::thread _analysisThread;
+	};
+}
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	struct CRZ_API RenderTimeHistogram
+	{
+		static constexpr uint64_t bucketCount = 32;
+
+		std::array<uint64_t, bucketCount> counts;
+		uint64_t renderCount;
+		double totalTime;
+		double maxTime;
+
+		static double getBucketLowerBound(uint64_t bucket);
+		double getMeanTime() const;
+	};
+
+	struct CRZ_API StreamStatistics
+	{
+		uint64_t callbackCount;
+		uint64_t inputUnderflowCount;
+		uint64_t inputOverflowCount;
+		uint64_t outputUnderflowCount;
+		uint64_t outputOverflowCount;
+		uint64_t silentBlockCount;
+		uint64_t droppedFrameCount;
+		double cpuLoad;
+
+		RenderTimeHistogram blockRenderTimes;
+		RenderTimeHistogram voiceRenderTimes;
+	};
+
+	class CRZ_API StreamMonitor
+	{
+		public:
+
+			StreamMonitor();
+			StreamMonitor(const StreamMonitor& monitor) = delete;
+			StreamMonitor(StreamMonitor&& monitor) = delete;
+
+			StreamMonitor& operator=(const StreamMonitor& monitor) = delete;
+			StreamMonitor& operator=(StreamMonitor&& monitor) = delete;
+
+			void addCallback(unsigned long statusFlags);
+			void addSilentBlock();
+			void addDroppedFrames(uint64_t frameCount);
+			void addBlockRenderTime(double time);
+			void addVoiceRenderTime(double time);
+
+			StreamStatistics getStatistics(void* stream) const;
+
+			~StreamMonitor() = default;
+
+		private:
+
+			struct Histogram
+			{
+				std::array<std::atomic<uint64_t>, RenderTimeHistogram::bucketCount> counts;
+				std::atomic<uint64_t> renderCount;
+				std::atomic<uint64_t> totalTime;
+				std::atomic<uint64_t> maxTime;
+			};
+
+			static void addRenderTime(Histogram& histogram, double time);
+			static void copyHistogram(const Histogram& histogram, RenderTimeHistogram& result);
+
+			std::atomic<uint64_t> _callbackCount;
+			std::atomic<uint64_t> _inputUnderflowCount;
+			std::atomic<uint64_t> _inputOverflowCount;
+			std::atomic<uint64_t> _outputUnderflowCount;
+			std::atomic<uint64_t> _outputOverflowCount;
+			std::atomic<uint64_t> _silentBlockCount;
+			std::atomic<uint64_t> _droppedFrameCount;
+
+			Histogram _blockRenderTimes;
+			Histogram _voiceRenderTimes;
+	};
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	class CRZ_API Trace
+	{
+		public:
+
+			Trace() = delete;
+
+			static void enable(uint64_t eventCountPerThread = 65536);
+			static void disable();
+			static bool isEnabled();
+			static void clear();
+
+			static void setThreadName(const std::string& name);
+
+			static bool writeChromeTrace(const std::filesystem::path& path);
+			static bool writePerfettoTrace(const std::filesystem::path& path);
+
+		private:
+
+			static uint64_t getTime();
+			static void addEvent(const char* name, uint64_t id, uint64_t start, uint64_t end);
+
+		friend class TraceSpan;
+	};
+
+	class CRZ_API TraceSpan
+	{
+		public:
+
+			TraceSpan(const char* name, uint64_t id = 0);
+			TraceSpan(const TraceSpan& span) = delete;
+			TraceSpan(TraceSpan&& span) = delete;
+
+			TraceSpan& operator=(const TraceSpan& span) = delete;
+			TraceSpan& operator=(TraceSpan&& span) = delete;
+
+			~TraceSpan();
+
+		private:
+
+			const char* _name;
+			uint64_t _id;
+			uint64_t _start;
+	};
+}
@@ -16,7 +16,50 @@ namespace crz
 	{
 		assert(isValid());
 
-		_sounds.emplace(_nextSoundId, new TSound(std::forward<Args>(args)...));
+		SoundBase* sound = new TSound(std::forward<Args>(args)...);
+
+		// A sound without frequency or channels, like a file that could not be opened, cannot be played
+
+		if (sound->getFrequency() == 0 || sound->getChannelCount() == 0)
+		{
+			delete sound;
+			return UINT64_MAX;
+		}
+
+		std::lock_guard lock(_scheduleMutex);
+		_sounds.emplace(_nextSoundId, sound);
+
+		return _nextSoundId++;
+	}
+
+	template<FiniteSound TSound, typename... Args>
+	uint64_t AudioOutput::createConvertedSound(Args&&... args)
+	{
+		assert(isValid());
+
+		// The sound is loaded in memory at the frequency and channel count of the output, it is then played without
+		// any conversion. Only sounds of known length can be loaded, streams and inputs are open ended. Filters added
+		// by the constructor of the sound are baked in the samples, the sound itself is deleted once converted.
+
+		TSound* sound = new TSound(std::forward<Args>(args)...);
+		SoundSource* source = sound->getFilteredSource();
+
+		if (source->getFrequency() == 0 || source->getChannelCount() == 0)
+		{
+			delete sound;
+			return UINT64_MAX;
+		}
+
+		SoundBase* convertedSound = sound;
+		if (source->getFrequency() != _frequency || source->getChannelCount() != _channelCount)
+		{
+			convertedSound = new SoundBuffer(*source, _frequency, _channelCount);
+			delete sound;
+		}
+
+		std::lock_guard lock(_scheduleMutex);
+		_sounds.emplace(_nextSoundId, convertedSound);
+
 		return _nextSoundId++;
 	}
 }
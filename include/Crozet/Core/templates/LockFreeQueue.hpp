@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreDecl.hpp>
+
+namespace crz
+{
+	// Bounded multi-producer multi-consumer queue, each cell carries a sequence number telling whether it is ready
+	// to be written or read for the current lap (D. Vyukov's algorithm).
+
+	template<typename TValue>
+	LockFreeQueue<TValue>::LockFreeQueue(uint64_t capacity) :
+		_mask(std::bit_ceil(std::max<uint64_t>(capacity, 2)) - 1),
+		_cells(nullptr),
+		_pushPosition(0),
+		_popPosition(0)
+	{
+		_cells = new Cell[_mask + 1];
+		for (uint64_t i = 0; i <= _mask; ++i)
+		{
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	template<typename TValue>
+	bool LockFreeQueue<TValue>::push(const TValue& value)
+	{
+		uint64_t position = _pushPosition.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = _cells + (position & _mask);
+			const int64_t difference = static_cast<int64_t>(cell->sequence.load(std::memory_order_acquire) - position);
+
+			if (difference == 0)
+			{
+				if (_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = _pushPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->value = value;
+		cell->sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template<typename TValue>
+	bool LockFreeQueue<TValue>::pop(TValue& value)
+	{
+		uint64_t position = _popPosition.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = _cells + (position & _mask);
+			const int64_t difference = static_cast<int64_t>(cell->sequence.load(std::memory_order_acquire) - (position + 1));
+
+			if (difference == 0)
+			{
+				if (_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = _popPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = cell->value;
+		cell->sequence.store(position + _mask + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template<typename TValue>
+	uint64_t LockFreeQueue<TValue>::getCapacity() const
+	{
+		return _mask + 1;
+	}
+
+	template<typename TValue>
+	LockFreeQueue<TValue>::~LockFreeQueue()
+	{
+		delete[] _cells;
+	}
+}
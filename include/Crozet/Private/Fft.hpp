@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+
+namespace crz
+{
+	namespace _crz
+	{
+		// Real FFT of a power of two size, computed as a complex FFT of half the size followed by a split of the even
+		// and odd parts. Tables are built once, the transforms do not allocate.
+		//
+		// Spectra are stored as separate arrays of real and imaginary parts, and the twiddles of each stage are
+		// contiguous, so that the butterflies are packed SIMD code.
+
+		class Fft
+		{
+			public:
+
+				Fft(uint64_t size) :
+					_size(size),
+					_reversedIndices(size / 2),
+					_twiddleReals(size / 2 - 1),
+					_twiddleImags(size / 2 - 1),
+					_splitReals(size / 2 + 1),
+					_splitImags(size / 2 + 1)
+				{
+					assert(size >= 4 && std::has_single_bit(size));
+
+					const uint64_t halfSize = size / 2;
+					const uint8_t bitCount = std::countr_zero(halfSize);
+
+					for (uint64_t i = 0; i < halfSize; ++i)
+					{
+						uint64_t reversed = 0;
+						for (uint8_t j = 0; j < bitCount; ++j)
+						{
+							reversed |= ((i >> j) & 1) << (bitCount - 1 - j);
+						}
+
+						_reversedIndices[i] = reversed;
+					}
+
+					// The twiddles of the stage of length L start at L / 2 - 1
+
+					for (uint64_t length = 2; length <= halfSize; length *= 2)
+					{
+						for (uint64_t j = 0; j < length / 2; ++j)
+						{
+							const double angle = -2.0 * std::numbers::pi * j / length;
+							_twiddleReals[length / 2 - 1 + j] = std::cos(angle);
+							_twiddleImags[length / 2 - 1 + j] = std::sin(angle);
+						}
+					}
+
+					for (uint64_t i = 0; i <= halfSize; ++i)
+					{
+						const double angle = -2.0 * std::numbers::pi * i / size;
+						_splitReals[i] = std::cos(angle);
+						_splitImags[i] = std::sin(angle);
+					}
+				}
+
+				uint64_t getSize() const
+				{
+					return _size;
+				}
+
+				uint64_t getBinCount() const
+				{
+					return _size / 2 + 1;
+				}
+
+				void transform(float* outputReals, float* outputImags, const float* input, float* scratch) const
+				{
+					// Even samples are the real parts and odd samples the imaginary parts of the half size input
+
+					const uint64_t halfSize = _size / 2;
+					float* reals = scratch;
+					float* imags = scratch + halfSize;
+
+					for (uint64_t i = 0; i < halfSize; ++i)
+					{
+						reals[_reversedIndices[i]] = input[2 * i];
+						imags[_reversedIndices[i]] = input[2 * i + 1];
+					}
+
+					computeButterflies(reals, imags, 1.f);
+
+					outputReals[0] = reals[0] + imags[0];
+					outputImags[0] = 0.f;
+					outputReals[halfSize] = reals[0] - imags[0];
+					outputImags[halfSize] = 0.f;
+
+					for (uint64_t k = 1; k < halfSize; ++k)
+					{
+						const float evenReal = 0.5f * (reals[k] + reals[halfSize - k]);
+						const float evenImag = 0.5f * (imags[k] - imags[halfSize - k]);
+						const float oddReal = 0.5f * (imags[k] + imags[halfSize - k]);
+						const float oddImag = -0.5f * (reals[k] - reals[halfSize - k]);
+
+						outputReals[k] = evenReal + _splitReals[k] * oddReal - _splitImags[k] * oddImag;
+						outputImags[k] = evenImag + _splitReals[k] * oddImag + _splitImags[k] * oddReal;
+					}
+				}
+
+				void inverseTransform(float* output, const float* inputReals, const float* inputImags, float* scratch) const
+				{
+					// The even and odd parts are recombined into a half size spectrum, whose inverse holds the even
+					// samples in its real parts and the odd samples in its imaginary parts
+
+					const uint64_t halfSize = _size / 2;
+					float* reals = scratch;
+					float* imags = scratch + halfSize;
+
+					for (uint64_t k = 0; k < halfSize; ++k)
+					{
+						const float evenReal = 0.5f * (inputReals[k] + inputReals[halfSize - k]);
+						const float evenImag = 0.5f * (inputImags[k] - inputImags[halfSize - k]);
+						const float diffReal = 0.5f * (inputReals[k] - inputReals[halfSize - k]);
+						const float diffImag = 0.5f * (inputImags[k] + inputImags[halfSize - k]);
+
+						const float oddReal = diffReal * _splitReals[k] + diffImag * _splitImags[k];
+						const float oddImag = diffImag * _splitReals[k] - diffReal * _splitImags[k];
+
+						reals[_reversedIndices[k]] = evenReal - oddImag;
+						imags[_reversedIndices[k]] = evenImag + oddReal;
+					}
+
+					computeButterflies(reals, imags, -1.f);
+
+					const float scale = 2.f / _size;
+					for (uint64_t i = 0; i < halfSize; ++i)
+					{
+						output[2 * i] = reals[i] * scale;
+						output[2 * i + 1] = imags[i] * scale;
+					}
+				}
+
+			private:
+
+				void computeButterflies(float* reals, float* imags, float direction) const
+				{
+					// The direction is the sign of the twiddle angles, negative for the inverse transform
+
+					const uint64_t halfSize = _size / 2;
+					for (uint64_t length = 2; length <= halfSize; length *= 2)
+					{
+						const uint64_t half = length / 2;
+						const float* twiddleReals = _twiddleReals.data() + half - 1;
+						const float* twiddleImags = _twiddleImags.data() + half - 1;
+
+						for (uint64_t i = 0; i < halfSize; i += length)
+						{
+							float* aReals = reals + i;
+							float* aImags = imags + i;
+							float* bReals = reals + i + half;
+							float* bImags = imags + i + half;
+
+							for (uint64_t j = 0; j < half; ++j)
+							{
+								const float twiddleImag = direction * twiddleImags[j];
+								const float real = bReals[j] * twiddleReals[j] - bImags[j] * twiddleImag;
+								const float imag = bReals[j] * twiddleImag + bImags[j] * twiddleReals[j];
+
+								bReals[j] = aReals[j] - real;
+								bImags[j] = aImags[j] - imag;
+								aReals[j] += real;
+								aImags[j] += imag;
+							}
+						}
+					}
+				}
+
+				uint64_t _size;
+				std::vector<uint64_t> _reversedIndices;
+				std::vector<float> _twiddleReals;
+				std::vector<float> _twiddleImags;
+				std::vector<float> _splitReals;
+				std::vector<float> _splitImags;
+		};
+	}
+}
@@ -0,0 +1,588 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <Crozet/Core/CoreTypes.hpp>
+#include <Crozet/Core/AudioDevice.hpp>
+
+namespace crz
+{
+	namespace _crz
+	{
+		// The loops below are kept branchless over contiguous arrays so that the compiler emits packed SIMD code.
+
+		inline int32_t floatToSample(float x)
+		{
+			return static_cast<int32_t>(std::clamp(x, -2147483648.f, 2147483520.f));
+		}
+
+		inline void applyGain(int32_t* samples, uint64_t sampleCount, float gain)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				samples[i] = floatToSample(static_cast<float>(samples[i]) * gain);
+			}
+		}
+
+		inline void applyGainRamp(int32_t* samples, uint64_t frameCount, uint16_t channelCount, const float* gains)
+		{
+			if (channelCount == 1)
+			{
+				for (uint64_t i = 0; i < frameCount; ++i)
+				{
+					samples[i] = floatToSample(static_cast<float>(samples[i]) * gains[i]);
+				}
+			}
+			else
+			{
+				for (uint64_t i = 0; i < frameCount; ++i, samples += channelCount)
+				{
+					for (uint16_t j = 0; j < channelCount; ++j)
+					{
+						samples[j] = floatToSample(static_cast<float>(samples[j]) * gains[i]);
+					}
+				}
+			}
+		}
+
+		// Each channel of the mix takes the gain of its side: sides[j] indexes sideGains, whose first entry is the gain of
+		// the channels that are not panned
+
+		inline void accumulate(float* mix, const int32_t* samples, uint64_t frameCount, uint16_t channelCount, const uint8_t* sides, const float* sideGains)
+		{
+			if (sideGains[0] == sideGains[1] && sideGains[0] == sideGains[2])
+			{
+				const uint64_t sampleCount = frameCount * channelCount;
+				for (uint64_t i = 0; i < sampleCount; ++i)
+				{
+					mix[i] += static_cast<float>(samples[i]) * sideGains[0];
+				}
+			}
+			else
+			{
+				for (uint64_t i = 0; i < frameCount; ++i, mix += channelCount, samples += channelCount)
+				{
+					for (uint16_t j = 0; j < channelCount; ++j)
+					{
+						mix[j] += static_cast<float>(samples[j]) * sideGains[sides[j]];
+					}
+				}
+			}
+		}
+
+		inline void accumulateRamp(float* mix, const int32_t* samples, uint64_t frameCount, uint16_t channelCount, const uint8_t* sides, const float* const* sideGains)
+		{
+			if (channelCount == 1)
+			{
+				const float* gains = sideGains[sides[0]];
+				for (uint64_t i = 0; i < frameCount; ++i)
+				{
+					mix[i] += static_cast<float>(samples[i]) * gains[i];
+				}
+			}
+			else
+			{
+				for (uint64_t i = 0; i < frameCount; ++i, mix += channelCount, samples += channelCount)
+				{
+					for (uint16_t j = 0; j < channelCount; ++j)
+					{
+						mix[j] += static_cast<float>(samples[j]) * sideGains[sides[j]][i];
+					}
+				}
+			}
+		}
+
+		inline void accumulateRouted(float* mix, uint16_t mixChannelCount, const int32_t* samples, uint64_t frameCount, uint16_t channelCount, const uint16_t* lanes, const uint8_t* sides, const float* sideGains)
+		{
+			for (uint64_t i = 0; i < frameCount; ++i, mix += mixChannelCount, samples += channelCount)
+			{
+				for (uint16_t j = 0; j < channelCount; ++j)
+				{
+					mix[lanes[j]] += static_cast<float>(samples[j]) * sideGains[sides[lanes[j]]];
+				}
+			}
+		}
+
+		inline void accumulateRoutedRamp(float* mix, uint16_t mixChannelCount, const int32_t* samples, uint64_t frameCount, uint16_t channelCount, const uint16_t* lanes, const uint8_t* sides, const float* const* sideGains)
+		{
+			for (uint64_t i = 0; i < frameCount; ++i, mix += mixChannelCount, samples += channelCount)
+			{
+				for (uint16_t j = 0; j < channelCount; ++j)
+				{
+					mix[lanes[j]] += static_cast<float>(samples[j]) * sideGains[sides[lanes[j]]][i];
+				}
+			}
+		}
+
+		inline void convertToFloat(float* output, const int32_t* samples, uint64_t sampleCount, float gain)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				output[i] = static_cast<float>(samples[i]) * gain;
+			}
+		}
+
+		inline void convertToFloatRamp(float* output, const int32_t* samples, uint64_t sampleCount, const float* gains)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				output[i] = static_cast<float>(samples[i]) * gains[i];
+			}
+		}
+
+		inline void accumulateLaneRamp(float* mix, uint16_t mixChannelCount, const float* samples, uint64_t frameCount, float from, float step)
+		{
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				mix[i * mixChannelCount] += samples[i] * (from + step * static_cast<float>(i));
+			}
+		}
+
+		// Sample format conversions. Samples are read from int32 or from the float mix (in the int32 scale), and
+		// written in native byte order. When the precision is reduced they are rounded, after adding a triangular
+		// noise of one output LSB if dithering is enabled. The noise of each sample is hashed from its position so
+		// that the loops stay free of dependencies between iterations.
+
+		inline int32_t toSample(int32_t x)
+		{
+			return x;
+		}
+
+		inline int32_t toSample(float x)
+		{
+			return floatToSample(x);
+		}
+
+		inline int32_t getDitherNoise(uint32_t position)
+		{
+			uint32_t hash = position * 0x9E3779B1u;
+			hash ^= hash >> 16;
+			hash *= 0x85EBCA6Bu;
+			hash ^= hash >> 13;
+			hash *= 0xC2B2AE35u;
+			hash ^= hash >> 16;
+
+			return static_cast<int32_t>(hash & 0xFFFF) - static_cast<int32_t>(hash >> 16);
+		}
+
+		template<bool TDither, typename TInput>
+		inline void encodeInt16(int16_t* output, const TInput* input, uint64_t sampleCount, uint32_t ditherPosition)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				const int32_t sample = toSample(input[i]);
+				const int32_t noise = TDither ? getDitherNoise(ditherPosition + static_cast<uint32_t>(i)) : 0;
+				const int32_t rounded = (sample >> 16) + (((sample & 0xFFFF) + 0x8000 + noise) >> 16);
+
+				output[i] = static_cast<int16_t>(std::clamp(rounded, -32768, 32767));
+			}
+		}
+
+		template<bool TDither, typename TInput>
+		inline void encodeInt24(uint8_t* output, const TInput* input, uint64_t sampleCount, uint32_t ditherPosition)
+		{
+			// PortAudio packs 24 bits samples on 3 bytes in native byte order
+
+			for (uint64_t i = 0; i < sampleCount; ++i, output += 3)
+			{
+				const int32_t sample = toSample(input[i]);
+				const int32_t noise = TDither ? (getDitherNoise(ditherPosition + static_cast<uint32_t>(i)) >> 8) : 0;
+				const int32_t rounded = (sample >> 8) + (((sample & 0xFF) + 0x80 + noise) >> 8);
+				const uint32_t packed = static_cast<uint32_t>(std::clamp(rounded, -8388608, 8388607));
+
+				if constexpr (std::endian::native == std::endian::little)
+				{
+					output[0] = packed;
+					output[1] = packed >> 8;
+					output[2] = packed >> 16;
+				}
+				else
+				{
+					output[0] = packed >> 16;
+					output[1] = packed >> 8;
+					output[2] = packed;
+				}
+			}
+		}
+
+		template<typename TInput>
+		inline void encodeInt32(int32_t* output, const TInput* input, uint64_t sampleCount)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				output[i] = toSample(input[i]);
+			}
+		}
+
+		inline void encodeFloat32(float* output, const int32_t* input, uint64_t sampleCount)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				output[i] = static_cast<float>(input[i]) * (1.f / 2147483648.f);
+			}
+		}
+
+		inline void encodeFloat32(float* output, const float* input, uint64_t sampleCount)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				output[i] = std::clamp(input[i] * (1.f / 2147483648.f), -1.f, 1.f);
+			}
+		}
+
+		inline void decodeInt16(int32_t* samples, const int16_t* input, uint64_t sampleCount)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				samples[i] = static_cast<int32_t>(static_cast<uint32_t>(input[i]) << 16);
+			}
+		}
+
+		inline void decodeInt24(int32_t* samples, const uint8_t* input, uint64_t sampleCount)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i, input += 3)
+			{
+				if constexpr (std::endian::native == std::endian::little)
+				{
+					samples[i] = static_cast<int32_t>((uint32_t(input[0]) << 8) | (uint32_t(input[1]) << 16) | (uint32_t(input[2]) << 24));
+				}
+				else
+				{
+					samples[i] = static_cast<int32_t>((uint32_t(input[2]) << 8) | (uint32_t(input[1]) << 16) | (uint32_t(input[0]) << 24));
+				}
+			}
+		}
+
+		inline void decodeFloat32(int32_t* samples, const float* input, uint64_t sampleCount)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i)
+			{
+				samples[i] = floatToSample(input[i] * 2147483648.f);
+			}
+		}
+
+		// Channel mixing kernels, fused with a linear resampling when TResample is set. Positions are in fixed point:
+		// output frame i reads the input at (position + i * step) / denominator, frames after lastFrame repeat it.
+
+		inline void resampleChannels(int32_t* output, const int32_t* input, uint64_t frameCount, uint16_t channelCount, uint64_t position, uint64_t step, uint64_t denominator, uint64_t lastFrame)
+		{
+			const float invDenominator = 1.f / static_cast<float>(denominator);
+
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				const uint64_t x = position + i * step;
+				const uint64_t index = x / denominator;
+				const float t = static_cast<float>(x - index * denominator) * invDenominator;
+
+				const int32_t* itA = input + std::min(index, lastFrame) * channelCount;
+				const int32_t* itB = input + std::min(index + 1, lastFrame) * channelCount;
+				for (uint16_t j = 0; j < channelCount; ++j, ++output)
+				{
+					const float a = static_cast<float>(itA[j]);
+					*output = floatToSample(a + (static_cast<float>(itB[j]) - a) * t);
+				}
+			}
+		}
+
+		template<bool TResample>
+		inline void routeChannels(int32_t* output, const int32_t* input, uint64_t frameCount, uint16_t outputChannelCount, uint16_t inputChannelCount, const uint16_t* sources, const float* gains, uint64_t position, uint64_t step, uint64_t denominator, uint64_t lastFrame)
+		{
+			const float invDenominator = 1.f / static_cast<float>(denominator);
+
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				const int32_t* itA = input + i * inputChannelCount;
+				const int32_t* itB = itA;
+				float t = 0.f;
+
+				if constexpr (TResample)
+				{
+					const uint64_t x = position + i * step;
+					const uint64_t index = x / denominator;
+					t = static_cast<float>(x - index * denominator) * invDenominator;
+
+					itA = input + std::min(index, lastFrame) * inputChannelCount;
+					itB = input + std::min(index + 1, lastFrame) * inputChannelCount;
+				}
+
+				for (uint16_t j = 0; j < outputChannelCount; ++j, ++output)
+				{
+					const float a = static_cast<float>(itA[sources[j]]);
+					*output = floatToSample(gains[j] * (a + (static_cast<float>(itB[sources[j]]) - a) * t));
+				}
+			}
+		}
+
+		template<bool TResample>
+		inline void mixChannels(int32_t* output, const int32_t* input, uint64_t frameCount, uint16_t outputChannelCount, uint16_t inputChannelCount, const float* coefficients, uint64_t position, uint64_t step, uint64_t denominator, uint64_t lastFrame)
+		{
+			const float invDenominator = 1.f / static_cast<float>(denominator);
+
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				const int32_t* itA = input + i * inputChannelCount;
+				const int32_t* itB = itA;
+				float t = 0.f;
+
+				if constexpr (TResample)
+				{
+					const uint64_t x = position + i * step;
+					const uint64_t index = x / denominator;
+					t = static_cast<float>(x - index * denominator) * invDenominator;
+
+					itA = input + std::min(index, lastFrame) * inputChannelCount;
+					itB = input + std::min(index + 1, lastFrame) * inputChannelCount;
+				}
+
+				// Both frames are mixed, then interpolated: the inner loops are dot products over the input channels
+
+				const float* itCoefficients = coefficients;
+				for (uint16_t j = 0; j < outputChannelCount; ++j, ++output, itCoefficients += inputChannelCount)
+				{
+					float a = 0.f, b = 0.f;
+					for (uint16_t k = 0; k < inputChannelCount; ++k)
+					{
+						a += itCoefficients[k] * static_cast<float>(itA[k]);
+						b += itCoefficients[k] * static_cast<float>(itB[k]);
+					}
+
+					*output = floatToSample(a + (b - a) * t);
+				}
+			}
+		}
+
+		inline void fillRamp(float* values, uint64_t count, float from, float step)
+		{
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				values[i] = from + step * static_cast<float>(i);
+			}
+		}
+
+		inline void fillExponential(float* values, uint64_t count, float scale, float logFrom, float logStep)
+		{
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				values[i] = scale * std::exp(logFrom + logStep * static_cast<float>(i));
+			}
+		}
+
+		inline void scaleInPlace(float* values, float factor, uint64_t count)
+		{
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				values[i] *= factor;
+			}
+		}
+
+		inline void multiplyInPlace(float* values, const float* factors, uint64_t count)
+		{
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				values[i] *= factors[i];
+			}
+		}
+
+		inline void computeFramePeaks(float* peaks, const float* samples, uint64_t frameCount, uint16_t channelCount)
+		{
+			if (channelCount == 2)
+			{
+				for (uint64_t i = 0; i < frameCount; ++i)
+				{
+					peaks[i] = std::max(std::abs(samples[2 * i]), std::abs(samples[2 * i + 1]));
+				}
+			}
+			else
+			{
+				for (uint64_t i = 0; i < frameCount; ++i)
+				{
+					peaks[i] = std::abs(samples[i * channelCount]);
+				}
+
+				for (uint16_t j = 1; j < channelCount; ++j)
+				{
+					for (uint64_t i = 0; i < frameCount; ++i)
+					{
+						peaks[i] = std::max(peaks[i], std::abs(samples[i * channelCount + j]));
+					}
+				}
+			}
+		}
+
+		inline void applyFrameGains(float* samples, const float* gains, uint64_t frameCount, uint16_t channelCount)
+		{
+			if (channelCount == 1)
+			{
+				multiplyInPlace(samples, gains, frameCount);
+			}
+			else if (channelCount == 2)
+			{
+				for (uint64_t i = 0; i < frameCount; ++i)
+				{
+					samples[2 * i] *= gains[i];
+					samples[2 * i + 1] *= gains[i];
+				}
+			}
+			else
+			{
+				for (uint64_t i = 0; i < frameCount; ++i, samples += channelCount)
+				{
+					for (uint16_t j = 0; j < channelCount; ++j)
+					{
+						samples[j] *= gains[i];
+					}
+				}
+			}
+		}
+
+		inline void addInPlace(float* values, const float* terms, uint64_t count)
+		{
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				values[i] += terms[i];
+			}
+		}
+
+		inline void subtractInPlace(float* values, const float* terms, uint64_t count)
+		{
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				values[i] -= terms[i];
+			}
+		}
+
+		// Metering kernels. Reductions are spread over independent lanes, the compiler would otherwise keep them
+		// sequential to preserve the order of floating point operations.
+
+		constexpr uint64_t reductionLaneCount = 8;
+
+		template<typename TInput>
+		inline void deinterleave(float* output, const TInput* input, uint64_t frameCount, uint16_t channelCount, float scale)
+		{
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				output[i] = static_cast<float>(input[i * channelCount]) * scale;
+			}
+		}
+
+		inline void interleave(int32_t* output, const float* input, uint64_t frameCount, uint16_t channelCount, float scale)
+		{
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				output[i * channelCount] = floatToSample(input[i] * scale);
+			}
+		}
+
+		template<typename TInput>
+		inline float sumSquares(const TInput* values, uint64_t count)
+		{
+			std::array<float, reductionLaneCount> sums = {};
+
+			uint64_t i = 0;
+			for (; i + reductionLaneCount <= count; i += reductionLaneCount)
+			{
+				for (uint64_t j = 0; j < reductionLaneCount; ++j)
+				{
+					const float value = static_cast<float>(values[i + j]);
+					sums[j] += value * value;
+				}
+			}
+
+			for (; i < count; ++i)
+			{
+				const float value = static_cast<float>(values[i]);
+				sums[0] += value * value;
+			}
+
+			float sum = 0.f;
+			for (uint64_t j = 0; j < reductionLaneCount; ++j)
+			{
+				sum += sums[j];
+			}
+
+			return sum;
+		}
+
+		inline float maxAbs(const float* values, uint64_t count)
+		{
+			// Absolute values are ordered like their bits as unsigned integers, which have an exact maximum
+
+			uint32_t max = 0;
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				max = std::max(max, std::bit_cast<uint32_t>(values[i]) & 0x7FFFFFFFu);
+			}
+
+			return std::bit_cast<float>(max);
+		}
+
+		inline void convolve(float* output, const float* input, uint64_t count, const float* taps, uint64_t tapCount)
+		{
+			std::fill_n(output, count, 0.f);
+			for (uint64_t k = 0; k < tapCount; ++k)
+			{
+				for (uint64_t i = 0; i < count; ++i)
+				{
+					output[i] += taps[k] * input[i + k];
+				}
+			}
+		}
+
+		// Spectral kernels. Complex spectra are stored as separate arrays of real and imaginary parts, which keeps the
+		// products packed.
+
+		inline void computeMagnitudes(float* magnitudes, const float* reals, const float* imags, uint64_t binCount, float scale)
+		{
+			for (uint64_t i = 0; i < binCount; ++i)
+			{
+				magnitudes[i] = std::sqrt(reals[i] * reals[i] + imags[i] * imags[i]) * scale;
+			}
+		}
+
+		inline void smoothPowers(float* powers, const float* reals, const float* imags, uint64_t binCount, float smoothing)
+		{
+			for (uint64_t i = 0; i < binCount; ++i)
+			{
+				powers[i] += (1.f - smoothing) * (reals[i] * reals[i] + imags[i] * imags[i] - powers[i]);
+			}
+		}
+
+		inline void multiplyAccumulateSpectrum(float* outputReals, float* outputImags, const float* aReals, const float* aImags, const float* bReals, const float* bImags, uint64_t binCount)
+		{
+			for (uint64_t i = 0; i < binCount; ++i)
+			{
+				outputReals[i] += aReals[i] * bReals[i] - aImags[i] * bImags[i];
+				outputImags[i] += aReals[i] * bImags[i] + aImags[i] * bReals[i];
+			}
+		}
+
+		inline void multiplyAccumulateConjugateSpectrum(float* outputReals, float* outputImags, const float* aReals, const float* aImags, const float* bReals, const float* bImags, const float* scales, uint64_t binCount)
+		{
+			for (uint64_t i = 0; i < binCount; ++i)
+			{
+				outputReals[i] += scales[i] * (aReals[i] * bReals[i] + aImags[i] * bImags[i]);
+				outputImags[i] += scales[i] * (aReals[i] * bImags[i] - aImags[i] * bReals[i]);
+			}
+		}
+
+		inline void smoothPhaseTransform(float* outputReals, float* outputImags, const float* aReals, const float* aImags, const float* bReals, const float* bImags, uint64_t binCount, float smoothing)
+		{
+			// Cross spectrum of a and b reduced to its phase, as used by the generalized cross correlation
+
+			for (uint64_t i = 0; i < binCount; ++i)
+			{
+				const float real = aReals[i] * bReals[i] + aImags[i] * bImags[i];
+				const float imag = aReals[i] * bImags[i] - aImags[i] * bReals[i];
+				const float norm = 1.f / (std::sqrt(real * real + imag * imag) + 1e-20f);
+
+				outputReals[i] += (1.f - smoothing) * (real * norm - outputReals[i]);
+				outputImags[i] += (1.f - smoothing) * (imag * norm - outputImags[i]);
+			}
+		}
+	}
+}
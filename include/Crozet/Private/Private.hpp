@@ -8,3 +8,30 @@
 #pragma once
 
 #include <portaudio.h>
+
+#include <Crozet/Private/Kernels.hpp>
+#include <Crozet/Private/Fft.hpp>
+
+namespace crz
+{
+	namespace _crz
+	{
+		bool acquirePortAudio();
+		void releasePortAudio();
+
+		inline PaSampleFormat toPaSampleFormat(SampleFormat format)
+		{
+			switch (format)
+			{
+				case SampleFormat::Int16:
+					return paInt16;
+				case SampleFormat::Int24:
+					return paInt24;
+				case SampleFormat::Float32:
+					return paFloat32;
+				default:
+					return paInt32;
+			}
+		}
+	}
+}
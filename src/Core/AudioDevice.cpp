@@ -10,53 +10,286 @@
 
 namespace crz
 {
+	namespace
+	{
+		constexpr std::array<double, 11> standardSampleRates = { 8000.0, 11025.0, 16000.0, 22050.0, 32000.0, 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+		// PortAudio is initialized once for the whole process, streams only hold a reference on it so that the devices
+		// are not listed again each time one is opened. The rates and formats of a device are only probed the first
+		// time it is queried, opening each device takes time on some host APIs
+
+		struct DeviceRegistry
+		{
+			std::mutex mutex;
+			bool initialized = false;
+			uint64_t streamCount = 0;
+
+			int defaultInputDevice = paNoDevice;
+			int defaultOutputDevice = paNoDevice;
+			std::vector<AudioDevice> devices;
+			std::vector<bool> probed;
+
+			~DeviceRegistry()
+			{
+				if (initialized)
+				{
+					Pa_Terminate();
+				}
+			}
+		};
+
+		DeviceRegistry& getDeviceRegistry()
+		{
+			static DeviceRegistry registry;
+			return registry;
+		}
+
+		bool isFormatSupported(int deviceIndex, bool input, uint16_t channelCount, double frequency, SampleFormat format)
+		{
+			const PaDeviceInfo* info = Pa_GetDeviceInfo(deviceIndex);
+
+			PaStreamParameters parameters;
+			parameters.device = deviceIndex;
+			parameters.channelCount = channelCount;
+			parameters.sampleFormat = _crz::toPaSampleFormat(format);
+			parameters.suggestedLatency = input ? info->defaultLowInputLatency : info->defaultLowOutputLatency;
+			parameters.hostApiSpecificStreamInfo = nullptr;
+
+			return Pa_IsFormatSupported(input ? &parameters : nullptr, input ? nullptr : &parameters, frequency) == paFormatIsSupported;
+		}
+
+		SampleFormat findNativeSampleFormat(int deviceIndex, bool input, uint16_t channelCount, double frequency)
+		{
+			// PortAudio does not expose the format the host works with, so the host API decides which formats are tried first
+
+			const PaDeviceInfo* info = Pa_GetDeviceInfo(deviceIndex);
+			const PaHostApiTypeId hostApi = Pa_GetHostApiInfo(info->hostApi)->type;
+
+			std::array<SampleFormat, 4> formats = { SampleFormat::Int32, SampleFormat::Int24, SampleFormat::Int16, SampleFormat::Float32 };
+			if (hostApi == paCoreAudio || hostApi == paJACK || hostApi == paWASAPI)
+			{
+				formats = { SampleFormat::Float32, SampleFormat::Int32, SampleFormat::Int24, SampleFormat::Int16 };
+			}
+
+			// Keep the first format the device accepts
+
+			for (SampleFormat format : formats)
+			{
+				if (isFormatSupported(deviceIndex, input, channelCount, frequency, format))
+				{
+					return format;
+				}
+			}
+
+			return SampleFormat::Int32;
+		}
+
+		void probeDirection(AudioDevice& device, bool input)
+		{
+			const uint16_t channelCount = input ? device.maxInputChannels : device.maxOutputChannels;
+			std::vector<double>& sampleRates = input ? device.inputSampleRates : device.outputSampleRates;
+			std::vector<SampleFormat>& sampleFormats = input ? device.inputSampleFormats : device.outputSampleFormats;
+			SampleFormat& nativeSampleFormat = input ? device.nativeInputSampleFormat : device.nativeOutputSampleFormat;
+
+			nativeSampleFormat = SampleFormat::Int32;
+			if (channelCount == 0)
+			{
+				return;
+			}
+
+			for (double sampleRate : standardSampleRates)
+			{
+				if (isFormatSupported(device.index, input, channelCount, sampleRate, SampleFormat::Int32))
+				{
+					sampleRates.push_back(sampleRate);
+				}
+			}
+
+			for (SampleFormat format : { SampleFormat::Int16, SampleFormat::Int24, SampleFormat::Int32, SampleFormat::Float32 })
+			{
+				if (isFormatSupported(device.index, input, channelCount, device.defaultSampleRate, format))
+				{
+					sampleFormats.push_back(format);
+				}
+			}
+
+			nativeSampleFormat = findNativeSampleFormat(device.index, input, channelCount, device.defaultSampleRate);
+		}
+
+		bool loadDevices(DeviceRegistry& registry)
+		{
+			// Must be called with the registry locked
+
+			if (registry.initialized)
+			{
+				return true;
+			}
+
+			if (Pa_Initialize())
+			{
+				return false;
+			}
+
+			registry.initialized = true;
+			registry.defaultInputDevice = Pa_GetDefaultInputDevice();
+			registry.defaultOutputDevice = Pa_GetDefaultOutputDevice();
+
+			const PaDeviceIndex deviceCount = Pa_GetDeviceCount();
+			for (PaDeviceIndex i = 0; i < deviceCount; ++i)
+			{
+				const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
+
+				AudioDevice& device = registry.devices.emplace_back();
+				device.index = i;
+				device.name = info->name;
+				device.hostApiName = Pa_GetHostApiInfo(info->hostApi)->name;
+				device.maxInputChannels = info->maxInputChannels;
+				device.maxOutputChannels = info->maxOutputChannels;
+				device.defaultLowInputLatency = info->defaultLowInputLatency;
+				device.defaultLowOutputLatency = info->defaultLowOutputLatency;
+				device.defaultHighInputLatency = info->defaultHighInputLatency;
+				device.defaultHighOutputLatency = info->defaultHighOutputLatency;
+				device.defaultSampleRate = info->defaultSampleRate;
+				device.nativeInputSampleFormat = SampleFormat::Int32;
+				device.nativeOutputSampleFormat = SampleFormat::Int32;
+			}
+
+			registry.probed.assign(deviceCount, false);
+
+			return true;
+		}
+
+		const AudioDevice& getProbedDevice(DeviceRegistry& registry, int deviceIndex)
+		{
+			// Must be called with the registry locked
+
+			AudioDevice& device = registry.devices[deviceIndex];
+			if (!registry.probed[deviceIndex])
+			{
+				probeDirection(device, true);
+				probeDirection(device, false);
+				registry.probed[deviceIndex] = true;
+			}
+
+			return device;
+		}
+	}
+
+	namespace _crz
+	{
+		bool acquirePortAudio()
+		{
+			DeviceRegistry& registry = getDeviceRegistry();
+			std::lock_guard lock(registry.mutex);
+
+			if (!loadDevices(registry))
+			{
+				return false;
+			}
+
+			++registry.streamCount;
+
+			return true;
+		}
+
+		void releasePortAudio()
+		{
+			DeviceRegistry& registry = getDeviceRegistry();
+			std::lock_guard lock(registry.mutex);
+
+			assert(registry.streamCount > 0);
+
+			--registry.streamCount;
+		}
+	}
+
 	int AudioDevice::getDefaultInputDeviceIndex()
 	{
-		Pa_Initialize();
-		PaDeviceIndex index = Pa_GetDefaultInputDevice();
-		Pa_Terminate();
+		DeviceRegistry& registry = getDeviceRegistry();
+		std::lock_guard lock(registry.mutex);
 
-		return index;
+		loadDevices(registry);
+
+		return registry.defaultInputDevice;
 	}
 
 	int AudioDevice::getDefaultOutputDeviceIndex()
 	{
-		Pa_Initialize();
-		PaDeviceIndex index = Pa_GetDefaultOutputDevice();
-		Pa_Terminate();
+		DeviceRegistry& registry = getDeviceRegistry();
+		std::lock_guard lock(registry.mutex);
+
+		loadDevices(registry);
 
-		return index;
+		return registry.defaultOutputDevice;
 	}
 
 	int AudioDevice::getDeviceCount()
 	{
-		Pa_Initialize();
-		PaDeviceIndex count = Pa_GetDeviceCount();
-		Pa_Terminate();
+		DeviceRegistry& registry = getDeviceRegistry();
+		std::lock_guard lock(registry.mutex);
+
+		loadDevices(registry);
 
-		return count;
+		return registry.devices.size();
 	}
 
 	AudioDevice AudioDevice::getAudioDevice(int deviceIndex)
 	{
-		Pa_Initialize();
+		DeviceRegistry& registry = getDeviceRegistry();
+		std::lock_guard lock(registry.mutex);
+
+		loadDevices(registry);
+
+		assert(deviceIndex >= 0 && deviceIndex < static_cast<int>(registry.devices.size()));
+
+		return getProbedDevice(registry, deviceIndex);
+	}
+
+	SampleFormat AudioDevice::getNativeSampleFormat(int deviceIndex, bool input, uint16_t channelCount, double frequency)
+	{
+		DeviceRegistry& registry = getDeviceRegistry();
+		std::lock_guard lock(registry.mutex);
+
+		loadDevices(registry);
+
+		assert(deviceIndex >= 0 && deviceIndex < static_cast<int>(registry.devices.size()));
+
+		// The usual configuration is probed once with the rest of the device and kept
+
+		const AudioDevice& device = registry.devices[deviceIndex];
+		if (frequency == device.defaultSampleRate && channelCount == (input ? device.maxInputChannels : device.maxOutputChannels))
+		{
+			const AudioDevice& probedDevice = getProbedDevice(registry, deviceIndex);
+			return input ? probedDevice.nativeInputSampleFormat : probedDevice.nativeOutputSampleFormat;
+		}
+
+		return findNativeSampleFormat(deviceIndex, input, channelCount, frequency);
+	}
+
+	bool AudioDevice::refreshDevices()
+	{
+		DeviceRegistry& registry = getDeviceRegistry();
+		std::lock_guard lock(registry.mutex);
 
-		assert(deviceIndex < getDeviceCount());
+		// PortAudio only sees devices plugged since its initialization once reinitialized, which cannot be done while
+		// streams are open
 
-		AudioDevice device;
-		const PaDeviceInfo* info = Pa_GetDeviceInfo(deviceIndex);
+		if (registry.streamCount != 0)
+		{
+			return false;
+		}
 
-		device.name = info->name;
-		device.maxInputChannels = info->maxInputChannels;
-		device.maxOutputChannels = info->maxOutputChannels;
-		device.defaultLowInputLatency = info->defaultLowInputLatency;
-		device.defaultLowOutputLatency = info->defaultLowOutputLatency;
-		device.defaultHighInputLatency = info->defaultHighInputLatency;
-		device.defaultHighOutputLatency = info->defaultHighOutputLatency;
-		device.defaultSampleRate = info->defaultSampleRate;
+		if (registry.initialized)
+		{
+			Pa_Terminate();
+			registry.initialized = false;
+		}
 
-		Pa_Terminate;
+		registry.defaultInputDevice = paNoDevice;
+		registry.defaultOutputDevice = paNoDevice;
+		registry.devices.clear();
+		registry.probed.clear();
 
-		return device;
+		return loadDevices(registry);
 	}
 }
@@ -14,13 +14,13 @@ namespace crz
 	{
 		int audioInputCallback(const void* input, void* output, unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData)
 		{
-			return audioInputMidCallback(reinterpret_cast<const int32_t*>(input), frameCount, reinterpret_cast<AudioInput*>(userData));
+			return audioInputMidCallback(input, frameCount, statusFlags, reinterpret_cast<AudioInput*>(userData));
 		}
 	}
 
-	int audioInputMidCallback(const int32_t* input, unsigned long frameCount, AudioInput* audioInput)
+	int audioInputMidCallback(const void* input, unsigned long frameCount, unsigned long statusFlags, AudioInput* audioInput)
 	{
-		return audioInput->internalCallback(input, frameCount);
+		return audioInput->internalCallback(input, frameCount, statusFlags);
 	}
 
 
@@ -30,14 +30,29 @@ namespace crz
 
 	AudioInput::AudioInput(int deviceIndex) : SoundBase(),
 		_stream(nullptr),
-		_storedSamples(0),
-		_samplesMutex(),
-		_samples()
+		_sampleFormat(SampleFormat::Int32),
+		_converter(),
+		_storedFrameCount(0),
+		_ring(nullptr),
+		_deviceSamples(),
+		_monitor(),
+		_loudnessMeter(),
+		_echoCanceller(nullptr),
+		_echoReference(nullptr),
+
+		_activityGateEnabled(false),
+		_activityOpenLevel(-40.f),
+		_activityCloseLevel(-50.f),
+		_activityHangoverFrameCount(0),
+		_active(true),
+		_hangoverFrameCount(0),
+		_activityTransitions(),
+		_activityTransitionTotal(0),
+		_activityEvents(_activityEventCapacity)
 	{
-		// Initialize PortAudio (can be done multiple times, each time will require one more Pa_Terminate)
+		// Take a reference on PortAudio, initialized once by the device registry
 
-		PaError error = Pa_Initialize();
-		if (error)
+		if (!_crz::acquirePortAudio())
 		{
 			return;
 		}
@@ -49,23 +64,39 @@ namespace crz
 		_channelCount = deviceInfo->maxInputChannels;
 		_sampleCount = 0;
 		_currentSample = 0;
-		_storedSamples = _frequency * _channelCount;
+		_storedFrameCount = _frequency;
+		_sampleFormat = AudioDevice::getNativeSampleFormat(deviceIndex, true, _channelCount, _frequency);
+		_converter = SampleConverter(_sampleFormat);
 		assert(_channelCount > 0);
 
+		_loudnessMeter.setFormat(_frequency, _channelCount);
+		_activityHangoverFrameCount.store(0.3 * _frequency, std::memory_order_relaxed);
+
+		if (_sampleFormat != SampleFormat::Int32)
+		{
+			_deviceSamples.resize(_frameCount * _channelCount);
+		}
+
+		// Every consumer of the capture reads the same ring, without removing anything from it
+
+		_ring = new BroadcastRing(_bufferLength * _frequency, _channelCount);
+
 		// Open stream from device infos
 
 		PaStreamParameters parameters;
 		parameters.device = deviceIndex;
 		parameters.channelCount = _channelCount;
-		parameters.sampleFormat = paInt32;
+		parameters.sampleFormat = _crz::toPaSampleFormat(_sampleFormat);
 		parameters.suggestedLatency = deviceInfo->defaultLowInputLatency;
 		parameters.hostApiSpecificStreamInfo = nullptr;
 
 		PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
-		error = Pa_OpenStream(&paStream, &parameters, nullptr, _frequency, _frameCount, paNoFlag, audioInputCallback, this);
+		PaError error = Pa_OpenStream(&paStream, &parameters, nullptr, _frequency, _frameCount, paNoFlag, audioInputCallback, this);
 		if (error)
 		{
-			Pa_Terminate();
+			delete _ring;
+			_ring = nullptr;
+			_crz::releasePortAudio();
 			return;
 		}
 
@@ -75,23 +106,63 @@ namespace crz
 		if (error)
 		{
 			Pa_CloseStream(paStream);
-			Pa_Terminate();
+			delete _ring;
+			_ring = nullptr;
+			_crz::releasePortAudio();
 			return;
 		}
 
-		// Start samples thread
-
 		_stream = reinterpret_cast<void*>(paStream);
 	}
 
 	void AudioInput::setStoredLength(double storedLength)
 	{
-		_storedSamples = storedLength * _frequency * _channelCount;
+		assert(isValid());
+		assert(storedLength >= 0.0);
+
+		_storedFrameCount = std::min<uint64_t>(storedLength * _frequency, _ring->getReadableFrameCount());
 	}
 
 	double AudioInput::getStoredLength() const
 	{
-		return static_cast<double>(_storedSamples) / (_frequency * _channelCount);
+		assert(isValid());
+
+		return static_cast<double>(_storedFrameCount) / _frequency;
+	}
+
+	const BroadcastRing& AudioInput::getRing() const
+	{
+		assert(isValid());
+
+		return *_ring;
+	}
+
+	SampleFormat AudioInput::getSampleFormat() const
+	{
+		assert(isValid());
+
+		return _sampleFormat;
+	}
+
+	StreamStatistics AudioInput::getStatistics() const
+	{
+		assert(isValid());
+
+		return _monitor.getStatistics(_stream);
+	}
+
+	LoudnessStatistics AudioInput::getLoudnessStatistics() const
+	{
+		assert(isValid());
+
+		return _loudnessMeter.getStatistics();
+	}
+
+	void AudioInput::resetLoudnessStatistics()
+	{
+		assert(isValid());
+
+		_loudnessMeter.reset();
 	}
 
 	bool AudioInput::isValid() const
@@ -99,45 +170,261 @@ namespace crz
 		return _stream;
 	}
 
-	int AudioInput::internalCallback(const int32_t* input, unsigned long frameCount)
+	void AudioInput::setActivityGateEnabled(bool enabled)
 	{
-		_samplesMutex.lock();
+		_activityGateEnabled.store(enabled, std::memory_order_relaxed);
+	}
 
-		_samples.insert(_samples.end(), input, input + frameCount * _channelCount);
-		_sampleCount += frameCount;
+	bool AudioInput::isActivityGateEnabled() const
+	{
+		return _activityGateEnabled.load(std::memory_order_relaxed);
+	}
+
+	void AudioInput::setActivityThresholds(float openLevel, float closeLevel)
+	{
+		assert(closeLevel <= openLevel);
+
+		_activityOpenLevel.store(openLevel, std::memory_order_relaxed);
+		_activityCloseLevel.store(closeLevel, std::memory_order_relaxed);
+	}
+
+	void AudioInput::setActivityHangover(double hangoverTime)
+	{
+		assert(isValid());
+		assert(hangoverTime >= 0.0);
+
+		_activityHangoverFrameCount.store(hangoverTime * _frequency, std::memory_order_relaxed);
+	}
+
+	bool AudioInput::isActive() const
+	{
+		// The gate state is the parity of the number of transitions, it starts open
+
+		return (_activityTransitionTotal.load(std::memory_order_acquire) & 1) == 0;
+	}
+
+	bool AudioInput::popActivityEvent(VoiceActivityEvent& event)
+	{
+		return _activityEvents.pop(event);
+	}
+
+	void AudioInput::setEchoReference(const AudioOutput* output)
+	{
+		assert(isValid());
+		assert(!output || output->getFrequency() == _frequency);
+
+		// The output knows the inputs reading its ring, so that it detaches them when it is destroyed
+
+		if (_echoReference)
+		{
+			_echoReference->removeEchoInput(this);
+		}
+
+		replaceEchoCanceller(output);
+
+		if (output)
+		{
+			output->addEchoInput(this);
+		}
+	}
+
+	const EchoCanceller* AudioInput::getEchoCanceller() const
+	{
+		return _echoCanceller;
+	}
 
-		const int64_t throwedSamples = _samples.size() - _storedSamples;
-		if (throwedSamples > 0)
+	bool AudioInput::isSilent(uint64_t timeFrom, uint64_t timeTo) const
+	{
+		if (!_activityGateEnabled.load(std::memory_order_relaxed))
 		{
-			_samples.erase(_samples.begin(), _samples.begin() + throwedSamples * _channelCount);
-			_currentSample += throwedSamples;
+			return false;
+		}
+
+		// The range is silent if the gate was closed at its start and did not open inside. Transitions are read from
+		// the most recent, those overwritten while being read make the answer unknown, and thus not silent.
+
+		const uint64_t transitionTotal = _activityTransitionTotal.load(std::memory_order_acquire);
+		const uint64_t firstTransition = transitionTotal - std::min(transitionTotal, _activityTransitionCount);
+
+		for (uint64_t i = transitionTotal; i > firstTransition; --i)
+		{
+			const uint64_t position = _activityTransitions[(i - 1) % _activityTransitionCount].load(std::memory_order_relaxed);
+
+			if (position >= timeTo)
+			{
+				continue;
+			}
+			else if (position > timeFrom)
+			{
+				return false;
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t overwrittenTotal = _activityTransitionTotal.load(std::memory_order_relaxed);
+
+			return (i & 1) == 1 && overwrittenTotal - i < _activityTransitionCount;
 		}
 
-		_samplesMutex.unlock();
+		return false;
+	}
+
+	int AudioInput::internalCallback(const void* input, unsigned long frameCount, unsigned long statusFlags)
+	{
+		const TraceSpan span("AudioInput::internalCallback", frameCount);
+		const std::chrono::steady_clock::time_point blockStart = std::chrono::steady_clock::now();
+
+		_monitor.addCallback(statusFlags);
+
+		// Samples are converted from the device format before being stored
+
+		const int32_t* samples = reinterpret_cast<const int32_t*>(input);
+		if (_sampleFormat != SampleFormat::Int32)
+		{
+			assert(frameCount * _channelCount <= _deviceSamples.size());
+
+			_converter.decode(_deviceSamples.data(), input, frameCount * _channelCount);
+			samples = _deviceSamples.data();
+		}
+
+		// The echo of the output is removed before anything reads the capture
+
+		if (_echoCanceller)
+		{
+			assert(frameCount * _channelCount <= _deviceSamples.size());
+
+			if (samples != _deviceSamples.data())
+			{
+				std::copy_n(samples, frameCount * _channelCount, _deviceSamples.data());
+			}
+
+			_echoCanceller->process(_deviceSamples.data(), frameCount);
+			samples = _deviceSamples.data();
+		}
+
+		updateActivity(samples, frameCount);
+		_ring->write(samples, frameCount);
+		_loudnessMeter.process(samples, frameCount);
+		_sampleCount += frameCount;
+
+		_monitor.addBlockRenderTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count());
 
 		return paContinue;
 	}
 
+	void AudioInput::updateActivity(const int32_t* samples, uint64_t frameCount)
+	{
+		// A disabled gate is left open, so that the capture is not considered silent when it is enabled again
+
+		if (!_activityGateEnabled.load(std::memory_order_relaxed))
+		{
+			if (!_active)
+			{
+				addActivityTransition(_sampleCount, true, 0.f);
+			}
+
+			return;
+		}
+
+		// The gate opens above the open level and closes once the level stayed below the close level for the
+		// hangover time
+
+		const uint64_t sampleCount = frameCount * _channelCount;
+		const float meanSquare = _crz::sumSquares(samples, sampleCount) / (static_cast<float>(sampleCount) * 4.611686e18f);
+		const float level = meanSquare > 0.f ? 10.f * std::log10(meanSquare) : -std::numeric_limits<float>::infinity();
+
+		if (level > _activityOpenLevel.load(std::memory_order_relaxed))
+		{
+			_hangoverFrameCount = 0;
+			if (!_active)
+			{
+				addActivityTransition(_sampleCount, true, level);
+			}
+		}
+		else if (_active && level < _activityCloseLevel.load(std::memory_order_relaxed))
+		{
+			_hangoverFrameCount += frameCount;
+			if (_hangoverFrameCount > _activityHangoverFrameCount.load(std::memory_order_relaxed))
+			{
+				addActivityTransition(_sampleCount, false, level);
+			}
+		}
+		else
+		{
+			_hangoverFrameCount = 0;
+		}
+	}
+
+	void AudioInput::addActivityTransition(uint64_t position, bool active, float level)
+	{
+		const uint64_t transitionTotal = _activityTransitionTotal.load(std::memory_order_relaxed);
+		_activityTransitions[transitionTotal % _activityTransitionCount].store(position, std::memory_order_relaxed);
+		_activityTransitionTotal.store(transitionTotal + 1, std::memory_order_release);
+
+		_active = active;
+		_hangoverFrameCount = 0;
+
+		// The control thread is expected to poll the events, they are dropped if it does not
+
+		VoiceActivityEvent event;
+		event.position = position;
+		event.active = active;
+		event.level = level;
+		_activityEvents.push(event);
+	}
+
+	void AudioInput::replaceEchoCanceller(const AudioOutput* output)
+	{
+		// The canceller is used by the callback, it is only replaced while the stream is stopped
+
+		PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+		Pa_StopStream(paStream);
+
+		delete _echoCanceller;
+		_echoCanceller = nullptr;
+		_echoReference = output;
+
+		if (output)
+		{
+			_echoCanceller = new EchoCanceller(output->getRing(), _frequency, _channelCount, 0.128, 0.25, _echoBlockSize);
+			_deviceSamples.resize(_frameCount * _channelCount);
+		}
+
+		Pa_StartStream(paStream);
+	}
+
 	void AudioInput::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
 	{
 		assert(isValid());
 
-		_samplesMutex.lock();
+		// Frames older than the stored length are considered lost, as they would be for a slow reader of the ring
 
-		if (timeFrom > _currentSample)
+		const uint64_t writePosition = _ring->getWritePosition();
+		const uint64_t storedPosition = writePosition - std::min(writePosition, _storedFrameCount);
+		const uint64_t from = std::clamp(timeFrom, storedPosition, timeTo);
+
+		std::fill_n(samples, (from - timeFrom) * _channelCount, 0);
+		if (isSilent(from, timeTo))
+		{
+			std::fill_n(samples + (from - timeFrom) * _channelCount, (timeTo - from) * _channelCount, 0);
+		}
+		else
 		{
-			_samples.erase(_samples.begin(), _samples.begin() + (timeFrom - _currentSample) * _channelCount);
-			_samples.shrink_to_fit();
+			// The callback may have overwritten the range while it was copied, in which case it is lost as well
+
+			int32_t* it = samples + (from - timeFrom) * _channelCount;
+			if (!_ring->copy(from, timeTo - from, it))
+			{
+				std::fill_n(it, (timeTo - from) * _channelCount, 0);
+				_monitor.addDroppedFrames(timeTo - from);
+			}
 		}
 
-		auto it = _samples.begin();
-		auto itEnd = it + (timeTo - timeFrom) * _channelCount;
-		std::copy(it, itEnd, samples);
+		if (from != timeFrom)
+		{
+			_monitor.addDroppedFrames(from - timeFrom);
+		}
 
-		_samples.erase(it, itEnd);
 		_currentSample = timeTo;
-
-		_samplesMutex.unlock();
 	}
 
 	AudioInput::~AudioInput()
@@ -146,9 +433,17 @@ namespace crz
 		{
 			PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
 
+			if (_echoReference)
+			{
+				_echoReference->removeEchoInput(this);
+			}
+
 			Pa_AbortStream(paStream);
 			Pa_CloseStream(paStream);
-			Pa_Terminate();
+			_crz::releasePortAudio();
+
+			delete _echoCanceller;
+			delete _ring;
 		}
 	}
 }
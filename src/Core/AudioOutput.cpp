@@ -16,13 +16,13 @@ namespace crz
 	{
 		int audioOutputCallback(const void* input, void* output, unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData)
 		{
-			return audioOutputMidCallback(reinterpret_cast<int32_t*>(output), frameCount, reinterpret_cast<AudioOutput*>(userData));
+			return audioOutputMidCallback(output, frameCount, statusFlags, reinterpret_cast<AudioOutput*>(userData));
 		}
 	}
 
-	int audioOutputMidCallback(int32_t* output, unsigned long frameCount, AudioOutput* audioOutput)
+	int audioOutputMidCallback(void* output, unsigned long frameCount, unsigned long statusFlags, AudioOutput* audioOutput)
 	{
-		return audioOutput->internalCallback(output, frameCount);
+		return audioOutput->internalCallback(output, frameCount, statusFlags);
 	}
 
 
@@ -32,9 +32,12 @@ namespace crz
 
 	AudioOutput::AudioOutput(int deviceIndex) :
 		_stream(nullptr),
+		_headless(false),
 
 		_frequency(0),
 		_channelCount(0),
+		_sampleFormat(SampleFormat::Int32),
+		_converter(),
 
 		_nextSoundId(0),
 		_sounds(),
@@ -42,17 +45,62 @@ namespace crz
 		_scheduleMutex(),
 		_currentTime(0),
 		_schedule(),
+		_fadeLength(0),
+
+		_routings(),
+
+		_spatializer(),
+		_spatialIndices(),
+		_spatialSoundIds(),
+		_spatialXs(),
+		_spatialYs(),
+		_spatialZs(),
+		_spatialGains(),
+		_previousSpatialGains(),
+
+		_limiter(nullptr),
+		_latency(0),
+
+		_automationEvents(_automationQueueCapacity),
+		_automations(),
+
+		_voiceSamples(),
+		_speedSamples(),
+		_positions(),
+		_speeds(),
+		_gains(),
+		_pans(),
+		_sideGains(),
+		_panSides(),
+		_fadeGains(),
+		_parameterValues(),
+		_spatialSamples(),
+		_mix(),
+
+		_monitor(),
+		_loudnessMeter(),
+		_ring(nullptr),
+		_ringMutex(),
+		_echoInputs(),
+		_echoMutex(),
 
 		_samplesThread(),
 		_samplesMutex(),
 		_samplesCondition(),
 		_samples(),
-		_samplesReady(false)
+		_deviceSamples(),
+		_samplesReady(false),
+		_renderedFrames(_frameCount),
+
+		_realtimeSettings(),
+		_realtimeReport(),
+		_realtimeCondition(),
+		_realtimeRequested(false),
+		_samplesStopping(false)
 	{
-		// Initialize PortAudio (can be done multiple times, each time will require one more Pa_Terminate)
+		// Take a reference on PortAudio, initialized once by the device registry
 
-		PaError error = Pa_Initialize();
-		if (error)
+		if (!_crz::acquirePortAudio())
 		{
 			return;
 		}
@@ -62,24 +110,26 @@ namespace crz
 		const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(deviceIndex);
 		_frequency = deviceInfo->defaultSampleRate;
 		_channelCount = deviceInfo->maxOutputChannels;
+		_sampleFormat = AudioDevice::getNativeSampleFormat(deviceIndex, false, _channelCount, _frequency);
+		_converter = SampleConverter(_sampleFormat);
 		assert(_channelCount > 0);
 
-		_samples.resize(_channelCount * _frameCount, 0);
+		allocateBuffers();
 
 		// Open stream from device infos
 
 		PaStreamParameters parameters;
 		parameters.device = deviceIndex;
 		parameters.channelCount = _channelCount;
-		parameters.sampleFormat = paInt32;
+		parameters.sampleFormat = _crz::toPaSampleFormat(_sampleFormat);
 		parameters.suggestedLatency = deviceInfo->defaultLowOutputLatency;
 		parameters.hostApiSpecificStreamInfo = nullptr;
 
 		PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
-		error = Pa_OpenStream(&paStream, nullptr, &parameters, _frequency, _frameCount, paNoFlag, audioOutputCallback, this);
+		PaError error = Pa_OpenStream(&paStream, nullptr, &parameters, _frequency, _frameCount, paNoFlag, audioOutputCallback, this);
 		if (error)
 		{
-			Pa_Terminate();
+			_crz::releasePortAudio();
 			return;
 		}
 
@@ -89,7 +139,7 @@ namespace crz
 		if (error)
 		{
 			Pa_CloseStream(paStream);
-			Pa_Terminate();
+			_crz::releasePortAudio();
 			return;
 		}
 
@@ -99,6 +149,82 @@ namespace crz
 		_samplesThread = std::thread(&AudioOutput::samplesComputationLoop, this);
 	}
 
+	AudioOutput::AudioOutput(uint32_t frequency, uint16_t channelCount) :
+		_stream(nullptr),
+		_headless(true),
+
+		_frequency(frequency),
+		_channelCount(channelCount),
+		_sampleFormat(SampleFormat::Int32),
+		_converter(),
+
+		_nextSoundId(0),
+		_sounds(),
+
+		_scheduleMutex(),
+		_currentTime(0),
+		_schedule(),
+		_fadeLength(0),
+
+		_routings(),
+
+		_spatializer(),
+		_spatialIndices(),
+		_spatialSoundIds(),
+		_spatialXs(),
+		_spatialYs(),
+		_spatialZs(),
+		_spatialGains(),
+		_previousSpatialGains(),
+
+		_limiter(nullptr),
+		_latency(0),
+
+		_automationEvents(_automationQueueCapacity),
+		_automations(),
+
+		_voiceSamples(),
+		_speedSamples(),
+		_positions(),
+		_speeds(),
+		_gains(),
+		_pans(),
+		_sideGains(),
+		_panSides(),
+		_fadeGains(),
+		_parameterValues(),
+		_spatialSamples(),
+		_mix(),
+
+		_monitor(),
+		_loudnessMeter(),
+		_ring(nullptr),
+		_ringMutex(),
+		_echoInputs(),
+		_echoMutex(),
+
+		_samplesThread(),
+		_samplesMutex(),
+		_samplesCondition(),
+		_samples(),
+		_deviceSamples(),
+		_samplesReady(false),
+		_renderedFrames(_frameCount),
+
+		_realtimeSettings(),
+		_realtimeReport(),
+		_realtimeCondition(),
+		_realtimeRequested(false),
+		_samplesStopping(false)
+	{
+		// A headless output has no stream nor samples thread, samples are computed when render is called
+
+		assert(_frequency > 0);
+		assert(_channelCount > 0);
+
+		allocateBuffers();
+	}
+
 	void AudioOutput::scheduleSound(uint64_t soundId, double delay, double startTime, double duration, bool removeWhenFinished)
 	{
 		assert(isValid());
@@ -110,14 +236,25 @@ namespace crz
 		// Compute schedule info
 
 		ScheduleInfo info;
-		info.scheduleTime = _currentTime + uint64_t(delay * _frequency);
+		info.scheduleTime = getScheduleTime(delay);
 		info.timeFrom = startTime * _frequency;
 		info.timeTo = duration < 0.0 ? UINT64_MAX : (startTime + duration) * _frequency;
 		info.removeWhenFinished = removeWhenFinished;
+		info.position = info.timeFrom;
+		info.readPosition = info.timeFrom;
+		info.history.resize(2 * _channelCount, 0);
+
+		info.loopStart = 0;
+		info.loopEnd = 0;
+		info.repeatCount = 0;
+		info.crossfadeLength = 0;
+		info.wrapCount = 0;
+		info.loopCacheStart = 0;
+		info.loopCacheEnd = 0;
 
 		// Start stream if it was stopped
 
-		if (_schedule.empty())
+		if (_schedule.empty() && !_headless)
 		{
 			PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
 			Pa_StartStream(paStream);
@@ -140,6 +277,65 @@ namespace crz
 		_scheduleMutex.unlock();
 	}
 
+	bool AudioOutput::setSoundLoop(uint64_t soundId, double loopStart, double loopEnd, uint64_t repeatCount)
+	{
+		assert(isValid());
+		assert(_sounds.find(soundId) != _sounds.end());
+		assert(loopStart >= 0.0 && loopEnd > loopStart);
+
+		const SoundSource* source = _sounds.find(soundId)->second->getFilteredSource();
+		const uint64_t sampleCount = source->getSampleCount() * _frequency / source->getFrequency();
+
+		// The loop belongs to the voice playing, or to the next one scheduled
+
+		_scheduleMutex.lock();
+
+		auto it = _schedule.find(soundId);
+		if (it == _schedule.end())
+		{
+			_scheduleMutex.unlock();
+			return false;
+		}
+
+		ScheduleInfo& info = it->second.front();
+		info.loopStart = loopStart * _frequency;
+		info.loopEnd = std::min<uint64_t>(loopEnd * _frequency, sampleCount);
+		info.repeatCount = info.loopEnd > info.loopStart ? repeatCount : 0;
+
+		// The seam is crossfaded with the frames preceding the loop, over the fade duration when the loop allows it
+
+		info.crossfadeLength = std::min({ _fadeLength, info.loopStart, (info.loopEnd - std::min(info.loopStart, info.loopEnd)) / 2 });
+		info.loopCacheStart = info.loopStart - info.crossfadeLength;
+		info.loopCacheEnd = std::min(info.loopStart + _frameCount, info.loopEnd);
+		info.loopCache.clear();
+
+		// The cache is filled on the mixing thread, it is given its capacity here for the widest voice possible
+
+		info.loopCache.reserve((info.loopCacheEnd - std::min(info.loopCacheStart, info.loopCacheEnd)) * _channelCount);
+
+		_scheduleMutex.unlock();
+
+		return true;
+	}
+
+	void AudioOutput::clearSoundLoop(uint64_t soundId)
+	{
+		assert(isValid());
+		assert(_sounds.find(soundId) != _sounds.end());
+
+		// The voice finishes the current pass of its loop and plays on past its end
+
+		_scheduleMutex.lock();
+
+		auto it = _schedule.find(soundId);
+		if (it != _schedule.end())
+		{
+			it->second.front().repeatCount = 0;
+		}
+
+		_scheduleMutex.unlock();
+	}
+
 	void AudioOutput::unscheduleSound(uint64_t soundId)
 	{
 		assert(isValid());
@@ -163,272 +359,1377 @@ namespace crz
 
 		unscheduleSound(soundId);
 
+		// The samples thread looks sounds up, the map is only changed with the schedule locked
+
+		_scheduleMutex.lock();
+		_automations.erase(soundId);
+		_routings.erase(soundId);
+		removeSpatialVoice(soundId);
+
 		auto it = _sounds.find(soundId);
-		delete it->second;
+		SoundBase* sound = it->second;
 		_sounds.erase(it);
+		_scheduleMutex.unlock();
+
+		delete sound;
 	}
 
-	const SoundBase* AudioOutput::getSound(uint64_t soundId) const
+	void AudioOutput::setSoundRouting(uint64_t soundId, const uint16_t* outputChannels, uint16_t channelCount)
 	{
 		assert(isValid());
+		assert(_sounds.find(soundId) != _sounds.end());
+		assert(channelCount <= _channelCount);
+		assert(std::all_of(outputChannels, outputChannels + channelCount, [&](uint16_t channel) { return channel < _channelCount; }));
 
-		auto it = _sounds.find(soundId);
-		if (it == _sounds.end())
+		// The sound is rendered with one channel per routed output channel, only those are mixed. Without routing it
+		// is rendered on every output channel.
+
+		_scheduleMutex.lock();
+
+		if (channelCount == 0)
 		{
-			return nullptr;
+			_routings.erase(soundId);
 		}
 		else
 		{
-			return it->second;
+			_routings[soundId].assign(outputChannels, outputChannels + channelCount);
 		}
+
+		_scheduleMutex.unlock();
 	}
 
-	SoundBase* AudioOutput::getSound(uint64_t soundId)
+	void AudioOutput::setSoundPosition(uint64_t soundId, float x, float y, float z)
 	{
 		assert(isValid());
+		assert(_sounds.find(soundId) != _sounds.end());
 
-		auto it = _sounds.find(soundId);
-		if (it == _sounds.end())
+		// Positioned sounds are rendered mono and panned by the spatializer, their routing and pan are ignored
+
+		_scheduleMutex.lock();
+
+		auto it = _spatialIndices.find(soundId);
+		if (it == _spatialIndices.end())
 		{
-			return nullptr;
+			it = _spatialIndices.emplace(soundId, _spatialSoundIds.size()).first;
+
+			_spatialSoundIds.push_back(soundId);
+			_spatialXs.push_back(x);
+			_spatialYs.push_back(y);
+			_spatialZs.push_back(z);
+
+			for (SpatialGains* gains : { &_spatialGains, &_previousSpatialGains })
+			{
+				gains->firstChannels.push_back(0);
+				gains->secondChannels.push_back(0);
+				gains->firstGains.push_back(0.f);
+				gains->secondGains.push_back(0.f);
+			}
+
+			// A new voice starts directly at its gains, without ramp
+
+			computeSpatialGains(it->second, 1);
 		}
 		else
 		{
-			return it->second;
+			_spatialXs[it->second] = x;
+			_spatialYs[it->second] = y;
+			_spatialZs[it->second] = z;
 		}
+
+		_scheduleMutex.unlock();
 	}
 
-	uint32_t AudioOutput::getFrequency() const
+	void AudioOutput::clearSoundPosition(uint64_t soundId)
 	{
 		assert(isValid());
 
-		return _frequency;
+		_scheduleMutex.lock();
+		removeSpatialVoice(soundId);
+		_scheduleMutex.unlock();
 	}
 
-	uint16_t AudioOutput::getChannelCount() const
+	void AudioOutput::setSpatializer(const Spatializer& spatializer)
 	{
 		assert(isValid());
+		assert(spatializer.getChannelCount() == _channelCount);
 
-		return _channelCount;
+		_scheduleMutex.lock();
+		_spatializer = spatializer;
+		_scheduleMutex.unlock();
 	}
 
-	bool AudioOutput::isValid() const
+	const Spatializer& AudioOutput::getSpatializer() const
 	{
-		return _stream;
+		assert(isValid());
+
+		return _spatializer;
 	}
 
-	AudioOutput::~AudioOutput()
+	bool AudioOutput::setLimiter(float threshold, double lookAhead, double release)
 	{
-		if (isValid())
-		{
-			PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+		assert(isValid());
 
-			Pa_AbortStream(paStream);
-			Pa_CloseStream(paStream);
-			Pa_Terminate();
+		Limiter* limiter = new Limiter(_frequency, _channelCount, threshold, lookAhead, release);
 
-			for (std::pair<const uint64_t, SoundBase*>& elt : _sounds)
-			{
-				delete elt.second;
-			}
-		}
-	}
+		_scheduleMutex.lock();
 
-	bool AudioOutput::canScheduleSound(uint64_t soundId, double delay, double startTime, double duration, bool removeWhenFinished) const
-	{
-		// Check sound exists
+		// A limiter with the same look-ahead is updated in place, it keeps the frames of its delay line. Changing the
+		// latency while voices are mixed would insert or drop frames, it is refused.
 
-		auto itSounds = _sounds.find(soundId);
-		if (itSounds == _sounds.end())
+		if (_limiter && _limiter->getLatency() == limiter->getLatency())
 		{
-			return false;
+			_limiter->setThreshold(threshold);
+			_limiter->setRelease(release);
 		}
-
-		// Check sound can be played starting at desired time
-
-		const SoundSource* source = itSounds->second->getFilteredSource();
-		if (startTime < source->getCurrentTime())
+		else if (!isMixingVoices())
 		{
-			return false;
+			std::swap(_limiter, limiter);
+			setLatency(_limiter->getLatency());
 		}
-
-		// If sound isn't already scheduled, shortcut the call
-
-		auto itSchedule = _schedule.find(soundId);
-		if (itSchedule == _schedule.end())
+		else
 		{
-			return true;
-		}
+			_scheduleMutex.unlock();
+			delete limiter;
 
-		const std::deque<ScheduleInfo>& infos = itSchedule->second;
+			return false;
+		}
 
-		// Check the same sound isn't playing twice at the same time and that there is no "rewind"
+		_scheduleMutex.unlock();
+		delete limiter;
 
-		const uint64_t timeFrom = startTime * _frequency;
-		const uint64_t timeTo = duration < 0.0 ? UINT64_MAX : (startTime + duration) * _frequency;
-		const uint64_t scheduleTime = _currentTime + uint64_t(delay * _frequency);
+		return true;
+	}
 
-		auto itInfo = infos.begin();
-		const auto itInfoEnd = infos.cend();
-		for (; itInfo != itInfoEnd; ++itInfo)
-		{
-			if (scheduleTime < itInfo->scheduleTime)
-			{
-				if (removeWhenFinished)
-				{
-					return false;
-				}
+	bool AudioOutput::removeLimiter()
+	{
+		assert(isValid());
 
-				if (scheduleTime + timeTo - timeFrom > itInfo->scheduleTime || timeTo > itInfo->timeFrom)
-				{
-					return false;
-				}
+		// The frames in the delay line of the limiter would be lost, it is only removed when no voice is mixed
 
-				break;
-			}
-			else
-			{
-				if (itInfo->removeWhenFinished)
-				{
-					return false;
-				}
-			}
-		}
+		_scheduleMutex.lock();
 
-		if (itInfo != infos.begin())
+		if (isMixingVoices())
 		{
-			--itInfo;
-			if (itInfo->scheduleTime + itInfo->timeTo - itInfo->timeFrom > scheduleTime || itInfo->timeTo > timeFrom)
-			{
-				return false;
-			}
-			++itInfo;
+			_scheduleMutex.unlock();
+			return false;
 		}
 
+		Limiter* limiter = _limiter;
+		_limiter = nullptr;
+		setLatency(0);
+
+		_scheduleMutex.unlock();
+		delete limiter;
+
 		return true;
 	}
 
-	int AudioOutput::internalCallback(int32_t* output, unsigned long frameCount)
+	double AudioOutput::getLatency() const
 	{
-		assert(frameCount * _channelCount == _samples.size());
-
-		std::unique_lock lock(_samplesMutex);
+		assert(isValid());
 
-		if (_samplesReady)
-		{
-			std::copy(_samples.begin(), _samples.end(), output);
-			_samplesReady = false;
-		}
-		else
-		{
-			std::fill_n(output, _samples.size(), 0);
-		}
+		return static_cast<double>(_latency.load(std::memory_order_relaxed)) / _frequency;
+	}
 
-		_samplesCondition.notify_one();
+	void AudioOutput::setFadeDuration(double fadeDuration)
+	{
+		assert(fadeDuration >= 0.0);
 
-		return paContinue;
+		_scheduleMutex.lock();
+		_fadeLength = fadeDuration * _frequency;
+		_scheduleMutex.unlock();
 	}
 
-	namespace
+	double AudioOutput::getFadeDuration() const
 	{
-		int32_t samplesStackFunc(int32_t x, int32_t y)
-		{
-			return std::clamp<int64_t>(static_cast<int64_t>(x) + static_cast<int64_t>(y), INT32_MIN, INT32_MAX);
-		}
+		return static_cast<double>(_fadeLength) / _frequency;
 	}
 
-	void AudioOutput::samplesComputationLoop()
+	bool AudioOutput::automateSound(uint64_t soundId, VoiceParameter parameter, double time, double value, AutomationCurve curve)
 	{
-		// This function runs while *this exists
-
-		PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+		assert(isValid());
+		assert(time >= 0.0);
 
-		while (true)
-		{
-			// Wait for samples to be emptied by the audio callback
+		// Automation times are heard times, they are moved back by the latency of the master bus
 
-			std::unique_lock lock(_samplesMutex);
-			_samplesCondition.wait(lock, [&] { return !_samplesReady; });
+		const uint64_t latency = _latency.load(std::memory_order_relaxed);
 
-			// Prepare samples range to be computed
+		AutomationEvent event;
+		event.soundId = soundId;
+		event.filterId = UINT64_MAX;
+		event.parameter = static_cast<uint32_t>(parameter);
+		event.time = std::max<uint64_t>(time * _frequency, latency) - latency;
+		event.value = value;
+		event.curve = curve;
 
-			_scheduleMutex.lock();
+		return _automationEvents.push(event);
+	}
 
-			std::fill(_samples.begin(), _samples.end(), 0);
-			std::vector<int32_t> buffer(_samples.size());
+	bool AudioOutput::automateFilter(uint64_t soundId, uint64_t filterId, uint32_t parameter, double time, double value, AutomationCurve curve)
+	{
+		assert(isValid());
+		assert(time >= 0.0);
+		assert(filterId != UINT64_MAX);
 
-			// For each sound currently playing in the schedule
+		const uint64_t latency = _latency.load(std::memory_order_relaxed);
 
-			auto itSchedule = _schedule.begin();
-			const auto itScheduleEnd = _schedule.cend();
-			for (; itSchedule != itScheduleEnd;)
-			{
-				ScheduleInfo& info = itSchedule->second.front();
+		AutomationEvent event;
+		event.soundId = soundId;
+		event.filterId = filterId;
+		event.parameter = parameter;
+		event.time = std::max<uint64_t>(time * _frequency, latency) - latency;
+		event.value = value;
+		event.curve = curve;
 
-				if (info.scheduleTime > _currentTime + _frameCount)
-				{
-					++itSchedule;
-					continue;
-				}
+		return _automationEvents.push(event);
+	}
 
-				// Compute samples to retrieve and retrieve them
+	const SoundBase* AudioOutput::getSound(uint64_t soundId) const
+	{
+		assert(isValid());
 
-				SoundSource* source = _sounds.find(itSchedule->first)->second->getFilteredSource();
-				const uint64_t sampleCount = source->getSampleCount() * _frequency / source->getFrequency();
-				const uint64_t timeFrom = info.timeFrom + (_currentTime > info.scheduleTime ? _currentTime - info.scheduleTime : 0);
-				const uint64_t offset = info.scheduleTime > _currentTime ? info.scheduleTime - _currentTime : 0;
-				const uint64_t timeTo = std::min(timeFrom + _frameCount - offset, info.timeTo);
+		auto it = _sounds.find(soundId);
+		if (it == _sounds.end())
+		{
+			return nullptr;
+		}
+		else
+		{
+			return it->second;
+		}
+	}
 
-				std::fill_n(buffer.begin(), offset, 0);
-				source->getSamples(_frequency, _channelCount, buffer.data() + offset, timeFrom, timeTo);
+	SoundBase* AudioOutput::getSound(uint64_t soundId)
+	{
+		assert(isValid());
 
-				// Stack them to the output samples
+		auto it = _sounds.find(soundId);
+		if (it == _sounds.end())
+		{
+			return nullptr;
+		}
+		else
+		{
+			return it->second;
+		}
+	}
 
-				std::transform(_samples.begin(), _samples.end(), buffer.begin(), _samples.begin(), samplesStackFunc);
+	uint32_t AudioOutput::getFrequency() const
+	{
+		assert(isValid());
 
-				// Remove the sound if the end was reached
+		return _frequency;
+	}
 
-				if (timeTo == info.timeTo || timeTo >= sampleCount)
+	uint16_t AudioOutput::getChannelCount() const
+	{
+		assert(isValid());
+
+		return _channelCount;
+	}
+
+	SampleFormat AudioOutput::getSampleFormat() const
+	{
+		assert(isValid());
+
+		return _sampleFormat;
+	}
+
+	double AudioOutput::getCurrentTime() const
+	{
+		assert(isValid());
+
+		return static_cast<double>(_currentTime) / _frequency;
+	}
+
+	StreamStatistics AudioOutput::getStatistics() const
+	{
+		assert(isValid());
+
+		return _monitor.getStatistics(_stream);
+	}
+
+	LoudnessStatistics AudioOutput::getLoudnessStatistics() const
+	{
+		assert(isValid());
+
+		return _loudnessMeter.getStatistics();
+	}
+
+	const BroadcastRing& AudioOutput::getRing() const
+	{
+		assert(isValid());
+
+		// The ring is only allocated and filled once something reads it, it starts empty at that point
+
+		BroadcastRing* ring = _ring.load(std::memory_order_acquire);
+		if (!ring)
+		{
+			std::lock_guard lock(_ringMutex);
+
+			ring = _ring.load(std::memory_order_relaxed);
+			if (!ring)
+			{
+				ring = new BroadcastRing(_ringLength * _frequency, _channelCount);
+				_ring.store(ring, std::memory_order_release);
+			}
+		}
+
+		return *ring;
+	}
+
+	void AudioOutput::resetLoudnessStatistics()
+	{
+		assert(isValid());
+
+		_loudnessMeter.reset();
+	}
+
+	bool AudioOutput::isValid() const
+	{
+		return _stream || _headless;
+	}
+
+	RealtimeReport AudioOutput::setRealtimeSettings(const RealtimeSettings& settings)
+	{
+		assert(isValid());
+
+		// A headless output computes its samples in the thread calling render, it is the one configured
+
+		if (_headless)
+		{
+			return settings.applyToCurrentThread();
+		}
+
+		// Otherwise the samples thread is woken to apply them, even when the stream is stopped
+
+		std::unique_lock lock(_samplesMutex);
+
+		_realtimeSettings = settings;
+		_realtimeRequested = true;
+		_samplesCondition.notify_all();
+		_realtimeCondition.wait(lock, [&] { return !_realtimeRequested; });
+
+		return _realtimeReport;
+	}
+
+	void AudioOutput::render(int32_t* samples, uint64_t frameCount)
+	{
+		assert(_headless);
+
+		// Samples are computed block by block, what was not consumed of the last block is kept for the next call
+
+		while (frameCount != 0)
+		{
+			if (_renderedFrames == _frameCount)
+			{
+				_scheduleMutex.lock();
+				computeSamples();
+				_scheduleMutex.unlock();
+
+				_renderedFrames = 0;
+			}
+
+			const uint64_t count = std::min(frameCount, _frameCount - _renderedFrames);
+			std::copy_n(_samples.data() + _renderedFrames * _channelCount, count * _channelCount, samples);
+
+			samples += count * _channelCount;
+			frameCount -= count;
+			_renderedFrames += count;
+		}
+	}
+
+	AudioOutput::~AudioOutput()
+	{
+		// Inputs cancelling the echo of this output read its ring, they are detached before it is deleted
+
+		std::vector<AudioInput*> echoInputs;
+		{
+			std::lock_guard lock(_echoMutex);
+			echoInputs.swap(_echoInputs);
+		}
+
+		for (AudioInput* input : echoInputs)
+		{
+			input->replaceEchoCanceller(nullptr);
+		}
+
+		if (isValid())
+		{
+			if (!_headless)
+			{
+				// The samples thread is stopped first, the callback outputs silence until the stream is aborted
+
+				{
+					std::lock_guard lock(_samplesMutex);
+					_samplesStopping = true;
+					_samplesCondition.notify_all();
+				}
+				_samplesThread.join();
+
+				PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+
+				Pa_AbortStream(paStream);
+				Pa_CloseStream(paStream);
+				_crz::releasePortAudio();
+			}
+
+			for (std::pair<const uint64_t, SoundBase*>& elt : _sounds)
+			{
+				delete elt.second;
+			}
+		}
+
+		delete _limiter;
+		delete _ring.load();
+	}
+
+	void AudioOutput::addEchoInput(AudioInput* input) const
+	{
+		std::lock_guard lock(_echoMutex);
+		_echoInputs.push_back(input);
+	}
+
+	void AudioOutput::removeEchoInput(AudioInput* input) const
+	{
+		std::lock_guard lock(_echoMutex);
+		std::erase(_echoInputs, input);
+	}
+
+	void AudioOutput::allocateBuffers()
+	{
+		_loudnessMeter.setFormat(_frequency, _channelCount);
+
+		_samples.resize(_channelCount * _frameCount, 0);
+		if (_sampleFormat != SampleFormat::Int32)
+		{
+			_deviceSamples.resize(_channelCount * _frameCount * _converter.getSampleSize(), 0);
+		}
+		_voiceSamples.resize(_channelCount * _frameCount, 0);
+		_positions.resize(_frameCount);
+		_speeds.resize(_frameCount);
+		_gains.resize(_frameCount);
+		_pans.resize(_frameCount);
+		_sideGains.resize(3 * _frameCount);
+		_fadeGains.resize(_frameCount);
+		_parameterValues.resize(_frameCount);
+		_spatialSamples.resize(_frameCount);
+		_mix.resize(_channelCount * _frameCount);
+
+		// Pan only moves the voice between the front left and right speakers, the other channels are left untouched.
+		// Without a standard layout, the first two channels are taken as the front pair.
+
+		_panSides.assign(_channelCount, 0);
+
+		const Speaker* speakers;
+		if (ChannelMatrix::getStandardLayout(_channelCount, speakers))
+		{
+			for (uint16_t i = 0; i < _channelCount; ++i)
+			{
+				_panSides[i] = speakers[i] == Speaker::FrontLeft ? 1 : (speakers[i] == Speaker::FrontRight ? 2 : 0);
+			}
+		}
+		else
+		{
+			_panSides[0] = 1;
+			_panSides[1] = 2;
+		}
+
+		_spatializer = Spatializer(_channelCount);
+
+		setFadeDuration(0.005);
+	}
+
+	bool AudioOutput::canScheduleSound(uint64_t soundId, double delay, double startTime, double duration, bool removeWhenFinished) const
+	{
+		// Check sound exists
+
+		auto itSounds = _sounds.find(soundId);
+		if (itSounds == _sounds.end())
+		{
+			return false;
+		}
+
+		// Check sound can be played starting at desired time
+
+		const SoundSource* source = itSounds->second->getFilteredSource();
+		if (startTime < source->getCurrentTime())
+		{
+			return false;
+		}
+
+		// If sound isn't already scheduled, shortcut the call
+
+		auto itSchedule = _schedule.find(soundId);
+		if (itSchedule == _schedule.end())
+		{
+			return true;
+		}
+
+		const std::deque<ScheduleInfo>& infos = itSchedule->second;
+
+		// Check the same sound isn't playing twice at the same time and that there is no "rewind"
+
+		const uint64_t timeFrom = startTime * _frequency;
+		const uint64_t timeTo = duration < 0.0 ? UINT64_MAX : (startTime + duration) * _frequency;
+		const uint64_t scheduleTime = getScheduleTime(delay);
+
+		auto itInfo = infos.begin();
+		const auto itInfoEnd = infos.cend();
+		for (; itInfo != itInfoEnd; ++itInfo)
+		{
+			if (scheduleTime < itInfo->scheduleTime)
+			{
+				if (removeWhenFinished)
+				{
+					return false;
+				}
+
+				if (scheduleTime + timeTo - timeFrom > itInfo->scheduleTime || timeTo > itInfo->timeFrom)
+				{
+					return false;
+				}
+
+				break;
+			}
+			else
+			{
+				if (itInfo->removeWhenFinished)
+				{
+					return false;
+				}
+			}
+		}
+
+		if (itInfo != infos.begin())
+		{
+			--itInfo;
+			if (itInfo->scheduleTime + itInfo->timeTo - itInfo->timeFrom > scheduleTime || itInfo->timeTo > timeFrom)
+			{
+				return false;
+			}
+			++itInfo;
+		}
+
+		return true;
+	}
+
+	int AudioOutput::internalCallback(void* output, unsigned long frameCount, unsigned long statusFlags)
+	{
+		assert(frameCount * _channelCount == _samples.size());
+
+		_monitor.addCallback(statusFlags);
+
+		std::unique_lock lock(_samplesMutex);
+
+		// The block was already converted to the device format when computed, only a copy remains
+
+		if (_samplesReady)
+		{
+			if (_sampleFormat == SampleFormat::Int32)
+			{
+				std::copy(_samples.begin(), _samples.end(), reinterpret_cast<int32_t*>(output));
+			}
+			else
+			{
+				std::copy(_deviceSamples.begin(), _deviceSamples.end(), reinterpret_cast<uint8_t*>(output));
+			}
+
+			_samplesReady = false;
+		}
+		else
+		{
+			std::fill_n(reinterpret_cast<uint8_t*>(output), _samples.size() * _converter.getSampleSize(), 0);
+			_monitor.addSilentBlock();
+		}
+
+		_samplesCondition.notify_one();
+
+		return paContinue;
+	}
+
+	void AudioOutput::setLatency(uint64_t latency)
+	{
+		// Sounds not started yet keep the time they were scheduled to be heard at (_scheduleMutex must be locked)
+
+		const uint64_t previousLatency = _latency.load(std::memory_order_relaxed);
+
+		for (std::pair<const uint64_t, std::deque<ScheduleInfo>>& infos : _schedule)
+		{
+			for (ScheduleInfo& info : infos.second)
+			{
+				if (info.scheduleTime > _currentTime)
+				{
+					info.scheduleTime = std::max(info.scheduleTime + previousLatency, _currentTime + latency) - latency;
+				}
+			}
+		}
+
+		_latency.store(latency, std::memory_order_relaxed);
+	}
+
+	uint64_t AudioOutput::getScheduleTime(double delay) const
+	{
+		// The delay is the one heard, the sound is mixed ahead of it by the latency of the master bus, when possible
+		// (_scheduleMutex must be locked)
+
+		const uint64_t latency = _latency.load(std::memory_order_relaxed);
+		return _currentTime + std::max<uint64_t>(delay * _frequency, latency) - latency;
+	}
+
+	bool AudioOutput::isMixingVoices() const
+	{
+		// Voices scheduled before the current time have been mixed already (_scheduleMutex must be locked)
+
+		for (const std::pair<const uint64_t, std::deque<ScheduleInfo>>& infos : _schedule)
+		{
+			if (infos.second.front().scheduleTime < _currentTime)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void AudioOutput::removeSpatialVoice(uint64_t soundId)
+	{
+		// The last voice takes the place of the removed one, to keep the arrays contiguous (_scheduleMutex must be
+		// locked)
+
+		auto it = _spatialIndices.find(soundId);
+		if (it == _spatialIndices.end())
+		{
+			return;
+		}
+
+		const uint64_t index = it->second;
+		const uint64_t last = _spatialSoundIds.size() - 1;
+		_spatialIndices.erase(it);
+
+		if (index != last)
+		{
+			_spatialIndices[_spatialSoundIds[last]] = index;
+
+			_spatialSoundIds[index] = _spatialSoundIds[last];
+			_spatialXs[index] = _spatialXs[last];
+			_spatialYs[index] = _spatialYs[last];
+			_spatialZs[index] = _spatialZs[last];
+
+			for (SpatialGains* gains : { &_spatialGains, &_previousSpatialGains })
+			{
+				gains->firstChannels[index] = gains->firstChannels[last];
+				gains->secondChannels[index] = gains->secondChannels[last];
+				gains->firstGains[index] = gains->firstGains[last];
+				gains->secondGains[index] = gains->secondGains[last];
+			}
+		}
+
+		_spatialSoundIds.pop_back();
+		_spatialXs.pop_back();
+		_spatialYs.pop_back();
+		_spatialZs.pop_back();
+
+		for (SpatialGains* gains : { &_spatialGains, &_previousSpatialGains })
+		{
+			gains->firstChannels.pop_back();
+			gains->secondChannels.pop_back();
+			gains->firstGains.pop_back();
+			gains->secondGains.pop_back();
+		}
+	}
+
+	void AudioOutput::computeSpatialGains(uint64_t voiceFrom, uint64_t voiceCount)
+	{
+		_spatializer.computeGains(_spatialXs.data() + voiceFrom, _spatialYs.data() + voiceFrom, _spatialZs.data() + voiceFrom, voiceCount,
+			_spatialGains.firstChannels.data() + voiceFrom, _spatialGains.secondChannels.data() + voiceFrom,
+			_spatialGains.firstGains.data() + voiceFrom, _spatialGains.secondGains.data() + voiceFrom);
+	}
+
+	void AudioOutput::applyAutomationEvents()
+	{
+		// Events are pushed by control threads without locking, they are moved in the lanes before each block
+
+		AutomationEvent event;
+		while (_automationEvents.pop(event))
+		{
+			// Events of a sound removed after they were pushed are dropped, they must not recreate its lanes
+
+			if (_sounds.find(event.soundId) == _sounds.end())
+			{
+				continue;
+			}
+
+			VoiceAutomation& automation = _automations.try_emplace(event.soundId).first->second;
+
+			if (event.filterId != UINT64_MAX)
+			{
+				const uint64_t key = (event.filterId << 32) | event.parameter;
+				automation.filterLanes.try_emplace(key, 0.f).first->second.addPoint(event.time, event.value, event.curve);
+			}
+			else
+			{
+				switch (static_cast<VoiceParameter>(event.parameter))
+				{
+					case VoiceParameter::Gain:
+					{
+						automation.gain.addPoint(event.time, std::max(event.value, 0.f), event.curve);
+						break;
+					}
+					case VoiceParameter::Pan:
+					{
+						automation.pan.addPoint(event.time, std::clamp(event.value, -1.f, 1.f), event.curve);
+						break;
+					}
+					case VoiceParameter::Speed:
+					{
+						automation.speed.addPoint(event.time, std::clamp(event.value, 0.f, _maxSpeed), event.curve);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	uint64_t AudioOutput::renderVoice(SoundBase* sound, ScheduleInfo& info, VoiceAutomation* automation, uint64_t time, uint64_t frameCount, uint16_t channelCount, const double*& positions)
+	{
+		SoundSource* source = sound->getFilteredSource();
+
+		// Send the automated filter parameters for the block before the filters are pulled
+
+		if (automation)
+		{
+			for (std::pair<const uint64_t, AutomationLane>& lane : automation->filterLanes)
+			{
+				FilterBase* filter = sound->getFilter(lane.first >> 32);
+				if (!filter)
+				{
+					continue;
+				}
+
+				float value;
+				if (lane.second.render(_parameterValues.data(), time, frameCount, value))
+				{
+					filter->setParameter(lane.first & UINT32_MAX, &value, 1);
+				}
+				else
+				{
+					filter->setParameter(lane.first & UINT32_MAX, _parameterValues.data(), frameCount);
+				}
+			}
+		}
+
+		float speed = 1.f;
+		const bool speedConstant = !automation || automation->speed.render(_speeds.data(), time, frameCount, speed);
+
+		// The frames at the start of a loop are read once and kept, so that wrapping does not wait on the source
+
+		const bool looping = info.repeatCount != 0 && info.position < info.loopEnd;
+		if (looping && info.loopCache.size() != (info.loopCacheEnd - info.loopCacheStart) * channelCount)
+		{
+			info.loopCache.resize((info.loopCacheEnd - info.loopCacheStart) * channelCount);
+			source->getSamples(_frequency, channelCount, info.loopCache.data(), info.loopCacheStart, info.loopCacheEnd);
+		}
+
+		// The block is rendered up to the end of the loop, then again from its start, as long as it repeats
+
+		uint64_t renderedFrames = 0;
+		while (renderedFrames < frameCount)
+		{
+			const bool wrapping = info.repeatCount != 0 && info.position < info.loopEnd;
+			const uint64_t timeTo = wrapping ? std::min(info.loopEnd, info.timeTo) : info.timeTo;
+			const double firstPosition = info.position;
+
+			int32_t* samples = _voiceSamples.data() + renderedFrames * channelCount;
+			const uint64_t remainingFrames = frameCount - renderedFrames;
+
+			// The positions of the frames in the sound are given back when they are not contiguous, for the last segment
+
+			uint64_t segmentFrames;
+			positions = nullptr;
+
+			if (speedConstant && speed == 1.f && info.position == static_cast<double>(info.readPosition))
+			{
+				// When the sound plays at its nominal speed and was read contiguously, pull it directly
+
+				const uint64_t timeFrom = info.readPosition;
+				const uint64_t segmentTo = std::min(timeFrom + remainingFrames, timeTo);
+
+				readVoiceSamples(source, info, samples, timeFrom, segmentTo, channelCount);
+
+				// Keep the last two frames read, they are needed if the speed changes on the next block
+
+				segmentFrames = segmentTo - timeFrom;
+				const uint64_t historyFrames = std::min<uint64_t>(segmentFrames, 2);
+				std::copy(info.history.begin() + historyFrames * channelCount, info.history.end(), info.history.begin());
+				std::copy_n(samples + (segmentFrames - historyFrames) * channelCount, historyFrames * channelCount, info.history.end() - historyFrames * channelCount);
+
+				info.position = segmentTo;
+				info.readPosition = segmentTo;
+			}
+			else
+			{
+				segmentFrames = renderVaryingSpeed(source, info, samples, speedConstant ? nullptr : _speeds.data() + renderedFrames, speed, remainingFrames, channelCount, timeTo);
+				positions = _positions.data();
+			}
+
+			if (wrapping && info.crossfadeLength != 0)
+			{
+				crossfadeLoopSeam(info, samples, positions, firstPosition, segmentFrames, channelCount);
+			}
+
+			renderedFrames += segmentFrames;
+
+			if (!wrapping || info.position < info.loopEnd)
+			{
+				break;
+			}
+
+			// Wrap without losing the fractional position, the source is then read again from the start of the loop
+
+			info.position -= info.loopEnd - info.loopStart;
+			info.readPosition = static_cast<uint64_t>(info.position);
+			++info.wrapCount;
+
+			if (info.repeatCount != UINT64_MAX)
+			{
+				--info.repeatCount;
+			}
+		}
+
+		return renderedFrames;
+	}
+
+	uint64_t AudioOutput::renderVaryingSpeed(SoundSource* source, ScheduleInfo& info, int32_t* samples, const float* speeds, float speed, uint64_t frameCount, uint16_t channelCount, uint64_t timeTo)
+	{
+		// Compute the position of each output frame in the sound, and stop at the end of the range
+
+		double position = info.position;
+		for (uint64_t i = 0; i < frameCount; ++i)
+		{
+			_positions[i] = position;
+			position += speeds ? speeds[i] : speed;
+		}
+
+		const uint64_t renderedFrames = std::lower_bound(_positions.begin(), _positions.begin() + frameCount, static_cast<double>(timeTo)) - _positions.begin();
+		if (renderedFrames == 0)
+		{
+			info.position = _positions[0];
+			return 0;
+		}
+
+		// Read the frames needed for interpolation. Sources are always read contiguously, the two last frames of the
+		// previous read are kept because the first frame of this block can fall between them.
+
+		const uint64_t firstFrame = _positions[0];
+		const uint64_t endFrame = static_cast<uint64_t>(_positions[renderedFrames - 1]) + 2;
+		assert(firstFrame + 2 >= info.readPosition);
+
+		const uint64_t neededSize = (endFrame - firstFrame) * channelCount;
+		if (_speedSamples.size() < neededSize)
+		{
+			_speedSamples.resize(neededSize);
+		}
+
+		uint64_t readFrom = info.readPosition;
+		if (firstFrame < readFrom)
+		{
+			const uint64_t cachedFrames = readFrom - firstFrame;
+			std::copy(info.history.end() - cachedFrames * channelCount, info.history.end(), _speedSamples.begin());
+		}
+		else
+		{
+			readFrom = firstFrame;
+		}
+
+		if (endFrame > readFrom)
+		{
+			readVoiceSamples(source, info, _speedSamples.data() + (readFrom - firstFrame) * channelCount, readFrom, endFrame, channelCount);
+			info.readPosition = endFrame;
+		}
+
+		const int32_t* itLast = _speedSamples.data() + (info.readPosition - firstFrame - 2) * channelCount;
+		std::copy_n(itLast, 2 * channelCount, info.history.begin());
+
+		// Interpolate linearly between frames
+
+		int32_t* itDst = samples;
+		for (uint64_t i = 0; i < renderedFrames; ++i)
+		{
+			const double x = _positions[i] - firstFrame;
+			const uint64_t index = x;
+			const float t = static_cast<float>(x - index);
+
+			const int32_t* itSrc = _speedSamples.data() + index * channelCount;
+			for (uint16_t j = 0; j < channelCount; ++j, ++itDst)
+			{
+				const float a = static_cast<float>(itSrc[j]);
+				const float b = static_cast<float>(itSrc[j + channelCount]);
+				*itDst = _crz::floatToSample(a + (b - a) * t);
+			}
+		}
+
+		// Past the end of the range, the position is the one of the first frame not rendered
+
+		info.position = renderedFrames == frameCount ? position : _positions[renderedFrames];
+
+		return renderedFrames;
+	}
+
+	void AudioOutput::readVoiceSamples(SoundSource* source, const ScheduleInfo& info, int32_t* samples, uint64_t timeFrom, uint64_t timeTo, uint16_t channelCount)
+	{
+		// The start of a loop is served from its cache, the rest from the source
+
+		if (!info.loopCache.empty() && timeFrom >= info.loopCacheStart && timeFrom < info.loopCacheEnd)
+		{
+			const uint64_t cachedTo = std::min(timeTo, info.loopCacheEnd);
+			std::copy_n(info.loopCache.data() + (timeFrom - info.loopCacheStart) * channelCount, (cachedTo - timeFrom) * channelCount, samples);
+
+			samples += (cachedTo - timeFrom) * channelCount;
+			timeFrom = cachedTo;
+		}
+
+		if (timeFrom < timeTo)
+		{
+			source->getSamples(_frequency, channelCount, samples, timeFrom, timeTo);
+		}
+	}
+
+	void AudioOutput::crossfadeLoopSeam(const ScheduleInfo& info, int32_t* samples, const double* positions, double firstPosition, uint64_t frameCount, uint16_t channelCount)
+	{
+		// The end of the loop fades into the frames preceding its start, so that the wrap continues them seamlessly.
+		// Those frames are at the beginning of the cache.
+
+		const double fadeStart = static_cast<double>(info.loopEnd - info.crossfadeLength);
+		const double loopLength = static_cast<double>(info.loopEnd - info.loopStart);
+		const uint64_t lastCacheFrame = info.loopCache.size() / channelCount - 1;
+
+		for (uint64_t i = 0; i < frameCount; ++i)
+		{
+			const double position = positions ? positions[i] : firstPosition + i;
+			if (position < fadeStart)
+			{
+				continue;
+			}
+
+			const float t = static_cast<float>((position - fadeStart) / info.crossfadeLength);
+
+			const double x = position - loopLength - info.loopCacheStart;
+			const uint64_t index = std::min<uint64_t>(x, lastCacheFrame);
+			const float u = static_cast<float>(x - index);
+
+			const int32_t* itCache = info.loopCache.data() + index * channelCount;
+			const int32_t* itNext = info.loopCache.data() + std::min(index + 1, lastCacheFrame) * channelCount;
+			int32_t* itDst = samples + i * channelCount;
+
+			for (uint16_t j = 0; j < channelCount; ++j)
+			{
+				const float a = static_cast<float>(itDst[j]);
+				const float b = static_cast<float>(itCache[j]) + (static_cast<float>(itNext[j]) - static_cast<float>(itCache[j])) * u;
+				itDst[j] = _crz::floatToSample(a + (b - a) * t);
+			}
+		}
+	}
+
+	const float* AudioOutput::applyScheduleFades(const ScheduleInfo& info, uint64_t timeFrom, uint64_t frameCount, const double* positions, bool contiguous, const float* gains, float gain)
+	{
+		if (_fadeLength == 0 || frameCount == 0)
+		{
+			return gains;
+		}
+
+		// Only cuts inside the sound are faded, its natural beginning and end are left untouched. The ramps follow the
+		// positions in the sound, which are not those of the block when the voice does not play at speed 1.
+
+		const double firstPosition = positions ? positions[0] : static_cast<double>(timeFrom);
+		const double endPosition = positions ? positions[frameCount - 1] + 1.0 : static_cast<double>(timeFrom + frameCount);
+		const bool fadeIn = contiguous && info.timeFrom != 0 && info.wrapCount == 0 && firstPosition < info.timeFrom + _fadeLength;
+		const bool fadeOut = info.timeTo != UINT64_MAX && endPosition + _fadeLength > info.timeTo;
+
+		if (!fadeIn && !fadeOut)
+		{
+			return gains;
+		}
+
+		// Fade is the minimum of the fade in and fade out ramps, each one saturating to 1 outside of its window
+
+		const float step = 1.f / _fadeLength;
+		float* fadeGains = _fadeGains.data();
+
+		if (positions)
+		{
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				const float fadeInGain = fadeIn ? static_cast<float>(positions[i] - info.timeFrom) * step : 1.f;
+				const float fadeOutGain = fadeOut ? static_cast<float>(info.timeTo - positions[i]) * step : 1.f;
+				fadeGains[i] = std::min(std::min(1.f, fadeInGain), fadeOutGain);
+			}
+		}
+		else
+		{
+			const float fadeInFrom = fadeIn ? static_cast<float>(timeFrom - info.timeFrom) : static_cast<float>(_fadeLength + frameCount);
+			const float fadeOutFrom = fadeOut ? static_cast<float>(info.timeTo - timeFrom) : static_cast<float>(_fadeLength + frameCount);
+
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				const float x = static_cast<float>(i);
+				fadeGains[i] = std::min(std::min(1.f, (fadeInFrom + x) * step), (fadeOutFrom - x) * step);
+			}
+		}
+
+		if (gains)
+		{
+			_crz::multiplyInPlace(fadeGains, gains, frameCount);
+		}
+		else
+		{
+			_crz::scaleInPlace(fadeGains, gain, frameCount);
+		}
+
+		return fadeGains;
+	}
+
+	void AudioOutput::mixVoice(float* mix, uint64_t frameCount, uint16_t channelCount, const uint16_t* lanes, const float* gains, float gain, const float* pans, float pan)
+	{
+		// Pan is a balance with constant power taper on each side: the centre leaves both channels untouched. Only the
+		// front left and right output channels are panned.
+
+		const auto leftGain = [](float x) { return x <= 0.f ? 1.f : std::cos(x * std::numbers::pi_v<float> / 2); };
+		const auto rightGain = [](float x) { return x >= 0.f ? 1.f : std::cos(x * std::numbers::pi_v<float> / 2); };
+
+		if (channelCount == 1)
+		{
+			pans = nullptr;
+			pan = 0.f;
+		}
+
+		if (!gains && !pans)
+		{
+			const float sideGains[3] = { gain, gain * leftGain(pan), gain * rightGain(pan) };
+
+			if (lanes)
+			{
+				_crz::accumulateRouted(mix, _channelCount, _voiceSamples.data(), frameCount, channelCount, lanes, _panSides.data(), sideGains);
+			}
+			else
+			{
+				_crz::accumulate(mix, _voiceSamples.data(), frameCount, _channelCount, _panSides.data(), sideGains);
+			}
+
+			return;
+		}
+
+		const float* sideGains[3] = { _sideGains.data(), _sideGains.data() + frameCount, _sideGains.data() + 2 * frameCount };
+		for (uint64_t i = 0; i < frameCount; ++i)
+		{
+			const float g = gains ? gains[i] : gain;
+			const float p = pans ? pans[i] : pan;
+			_sideGains[i] = g;
+			_sideGains[frameCount + i] = g * leftGain(p);
+			_sideGains[2 * frameCount + i] = g * rightGain(p);
+		}
+
+		if (lanes)
+		{
+			_crz::accumulateRoutedRamp(mix, _channelCount, _voiceSamples.data(), frameCount, channelCount, lanes, _panSides.data(), sideGains);
+		}
+		else
+		{
+			_crz::accumulateRamp(mix, _voiceSamples.data(), frameCount, _channelCount, _panSides.data(), sideGains);
+		}
+	}
+
+	void AudioOutput::mixSpatialVoice(float* mix, uint64_t frameCount, uint64_t spatialIndex, const float* gains, float gain)
+	{
+		// The voice reaches at most four output channels: the two it was panned on during the previous block and the
+		// two it is panned on now. Each one gets a ramp from its previous gain to its current gain.
+
+		std::array<uint16_t, 4> lanes;
+		std::array<float, 4> fromGains, toGains;
+		uint16_t laneCount = 0;
+
+		const auto addLane = [&](uint16_t channel, float fromGain, float toGain)
+		{
+			uint16_t i = 0;
+			while (i != laneCount && lanes[i] != channel)
+			{
+				++i;
+			}
+
+			if (i == laneCount)
+			{
+				lanes[i] = channel;
+				fromGains[i] = 0.f;
+				toGains[i] = 0.f;
+				++laneCount;
+			}
+
+			fromGains[i] += fromGain;
+			toGains[i] += toGain;
+		};
+
+		addLane(_previousSpatialGains.firstChannels[spatialIndex], _previousSpatialGains.firstGains[spatialIndex], 0.f);
+		addLane(_previousSpatialGains.secondChannels[spatialIndex], _previousSpatialGains.secondGains[spatialIndex], 0.f);
+		addLane(_spatialGains.firstChannels[spatialIndex], 0.f, _spatialGains.firstGains[spatialIndex]);
+		addLane(_spatialGains.secondChannels[spatialIndex], 0.f, _spatialGains.secondGains[spatialIndex]);
+
+		// The voice gain is applied once on the mono samples, the lanes only add their ramp
+
+		if (gains)
+		{
+			_crz::convertToFloatRamp(_spatialSamples.data(), _voiceSamples.data(), frameCount, gains);
+		}
+		else
+		{
+			_crz::convertToFloat(_spatialSamples.data(), _voiceSamples.data(), frameCount, gain);
+		}
+
+		for (uint16_t i = 0; i < laneCount; ++i)
+		{
+			if (fromGains[i] != 0.f || toGains[i] != 0.f)
+			{
+				const float step = (toGains[i] - fromGains[i]) / frameCount;
+				_crz::accumulateLaneRamp(mix + lanes[i], _channelCount, _spatialSamples.data(), frameCount, fromGains[i], step);
+			}
+		}
+	}
+
+	void AudioOutput::samplesComputationLoop()
+	{
+		// This function runs until *this is destroyed
+
+		Trace::setThreadName("Crozet samples computation");
+
+		PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+
+		while (true)
+		{
+			// Wait for samples to be emptied by the audio callback
+
+			std::unique_lock lock(_samplesMutex);
+			_samplesCondition.wait(lock, [&] { return !_samplesReady || _realtimeRequested || _samplesStopping; });
+
+			if (_samplesStopping)
+			{
+				return;
+			}
+
+			// Realtime settings are applied by the thread to itself, between two blocks
+
+			if (_realtimeRequested)
+			{
+				_realtimeReport = _realtimeSettings.applyToCurrentThread();
+				_realtimeRequested = false;
+				_realtimeCondition.notify_all();
+
+				continue;
+			}
+
+			// Compute the samples and mark them as ready
+
+			_scheduleMutex.lock();
+
+			computeSamples();
+			_samplesReady = true;
+
+			// Stop the stream if timeline is empty. Stopping waits for the callback, which needs the samples mutex.
+
+			lock.unlock();
+
+			if (_schedule.empty())
+			{
+				Pa_StopStream(paStream);
+			}
+
+			_scheduleMutex.unlock();
+		}
+	}
+
+	void AudioOutput::computeSamples()
+	{
+		// Prepare samples range to be computed (_scheduleMutex must be locked)
+
+		const TraceSpan blockSpan("AudioOutput::computeSamples", _currentTime);
+		const std::chrono::steady_clock::time_point blockStart = std::chrono::steady_clock::now();
+
+		applyAutomationEvents();
+
+		// Gains of all the positioned voices are computed in one batch, the previous ones are kept for the ramps
+
+		if (!_spatialSoundIds.empty())
+		{
+			std::swap(_spatialGains, _previousSpatialGains);
+			computeSpatialGains(0, _spatialSoundIds.size());
+		}
+
+		std::fill(_mix.begin(), _mix.end(), 0.f);
+
+		// For each sound currently playing in the schedule
+
+		auto itSchedule = _schedule.begin();
+		const auto itScheduleEnd = _schedule.cend();
+		for (; itSchedule != itScheduleEnd;)
+		{
+			ScheduleInfo& info = itSchedule->second.front();
+
+			if (info.scheduleTime > _currentTime + _frameCount)
+			{
+				++itSchedule;
+				continue;
+			}
+
+			// Retrieve the samples of the sound for the part of the block it is scheduled on
+
+			SoundBase* sound = _sounds.find(itSchedule->first)->second;
+			SoundSource* source = sound->getFilteredSource();
+			const uint64_t sampleCount = source->getSampleCount() * _frequency / source->getFrequency();
+			const uint64_t offset = info.scheduleTime > _currentTime ? info.scheduleTime - _currentTime : 0;
+			const uint64_t time = _currentTime + offset;
+			const uint64_t timeFrom = info.position;
+
+			const TraceSpan voiceSpan("AudioOutput::voice", itSchedule->first);
+			const std::chrono::steady_clock::time_point voiceStart = std::chrono::steady_clock::now();
+
+			auto itAutomation = _automations.find(itSchedule->first);
+			VoiceAutomation* automation = itAutomation == _automations.end() ? nullptr : &itAutomation->second;
+
+			// Routed voices are rendered on their own channels only
+
+			auto itSpatial = _spatialIndices.find(itSchedule->first);
+			auto itRouting = _routings.find(itSchedule->first);
+			const bool spatialized = itSpatial != _spatialIndices.end();
+			const uint16_t* lanes = spatialized || itRouting == _routings.end() ? nullptr : itRouting->second.data();
+			const uint16_t channelCount = spatialized ? 1 : (lanes ? itRouting->second.size() : _channelCount);
+
+			if (info.history.size() != 2 * channelCount)
+			{
+				info.history.assign(2 * channelCount, 0);
+			}
+
+			const uint64_t wrapCount = info.wrapCount;
+			const double* positions = nullptr;
+			const uint64_t frameCount = renderVoice(sound, info, automation, time, _frameCount - offset, channelCount, positions);
+			const uint64_t timeTo = info.position;
+			const bool wrapped = info.wrapCount != wrapCount;
+
+			// Evaluate gain and pan for the block and stack the sound to the output samples
+
+			float gain = 1.f, pan = 0.f;
+			const float* gains = nullptr;
+			const float* pans = nullptr;
+
+			if (automation)
+			{
+				if (!automation->gain.render(_gains.data(), time, frameCount, gain))
 				{
-					if (info.removeWhenFinished)
-					{
-						delete _sounds.find(itSchedule->first)->second;
-						_sounds.erase(itSchedule->first);
-					}
+					gains = _gains.data();
+				}
+
+				if (!automation->pan.render(_pans.data(), time, frameCount, pan))
+				{
+					pans = _pans.data();
+				}
+			}
 
-					itSchedule->second.pop_front();
+			// A block that wrapped around a loop is not a contiguous range of the sound, the seam is crossfaded instead
+			// of faded in. It is still faded out, back from where it ends.
 
-					if (itSchedule->second.empty())
-					{
-						auto itErased = itSchedule;
-						++itSchedule;
+			const uint64_t fadeFrom = wrapped ? timeTo - std::min(timeTo, frameCount) : timeFrom;
+			gains = applyScheduleFades(info, fadeFrom, frameCount, wrapped ? nullptr : positions, !wrapped, gains, gain);
 
-						_schedule.erase(itErased);
-					}
-					else
-					{
-						++itSchedule;
-					}
+			// Ranges the source knows to be silent are not mixed, the range read includes the interpolated frames
+
+			const uint32_t sourceFrequency = source->getFrequency();
+			const bool silent = !wrapped && source->isSilent(timeFrom * sourceFrequency / _frequency, (timeTo * sourceFrequency + _frequency - 1) / _frequency + 1);
+
+			if (!silent && spatialized)
+			{
+				mixSpatialVoice(_mix.data() + offset * _channelCount, frameCount, itSpatial->second, gains, gain);
+			}
+			else if (!silent)
+			{
+				mixVoice(_mix.data() + offset * _channelCount, frameCount, channelCount, lanes, gains, gain, pans, pan);
+			}
+
+			_monitor.addVoiceRenderTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - voiceStart).count());
+
+			// Remove the sound if the end was reached
+
+			if (timeTo >= info.timeTo || timeTo >= sampleCount)
+			{
+				if (info.removeWhenFinished)
+				{
+					delete _sounds.find(itSchedule->first)->second;
+					_sounds.erase(itSchedule->first);
+					_automations.erase(itSchedule->first);
+					_routings.erase(itSchedule->first);
+					removeSpatialVoice(itSchedule->first);
+				}
+
+				itSchedule->second.pop_front();
+
+				if (itSchedule->second.empty())
+				{
+					auto itErased = itSchedule;
+					++itSchedule;
+
+					_schedule.erase(itErased);
 				}
 				else
 				{
 					++itSchedule;
 				}
 			}
+			else
+			{
+				++itSchedule;
+			}
+		}
 
-			// Mark the samples as ready
-
-			_currentTime += _frameCount;
-			_samplesReady = true;
+		// Drop the automation points that are now in the past
 
-			// Stop the stream if timeline is empty
+		for (std::pair<const uint64_t, VoiceAutomation>& automation : _automations)
+		{
+			automation.second.gain.discardBefore(_currentTime);
+			automation.second.pan.discardBefore(_currentTime);
+			automation.second.speed.discardBefore(_currentTime);
 
-			if (_schedule.empty())
+			for (std::pair<const uint64_t, AutomationLane>& lane : automation.second.filterLanes)
 			{
-				Pa_StopStream(paStream);
+				lane.second.discardBefore(_currentTime);
 			}
+		}
 
-			_scheduleMutex.unlock();
+		// The master bus is limited instead of clipped, the limiter delays it by its look-ahead
+
+		if (_limiter)
+		{
+			_limiter->process(_mix.data(), _frameCount);
+		}
+
+		// Convert the mix to output samples, directly in the device format when it is not the pipeline's
+
+		if (_sampleFormat == SampleFormat::Int32)
+		{
+			_converter.encode(_samples.data(), _mix.data(), _mix.size());
+		}
+		else
+		{
+			_converter.encode(_deviceSamples.data(), _mix.data(), _mix.size());
+			_crz::encodeInt32(_samples.data(), _mix.data(), _mix.size());
+		}
+
+		// The output is kept in a ring for the analyzers, they do their work on their own threads
+
+		BroadcastRing* ring = _ring.load(std::memory_order_acquire);
+		if (ring)
+		{
+			ring->write(_samples.data(), _frameCount);
 		}
+		_loudnessMeter.process(_mix.data(), _frameCount);
+
+		_monitor.addBlockRenderTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count());
+
+		_currentTime += _frameCount;
 	}
 }
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	namespace
+	{
+		int audioStreamCallback(const void* input, void* output, unsigned long frameCount, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData)
+		{
+			return audioStreamMidCallback(input, output, frameCount, statusFlags, reinterpret_cast<AudioStream*>(userData));
+		}
+	}
+
+	int audioStreamMidCallback(const void* input, void* output, unsigned long frameCount, unsigned long statusFlags, AudioStream* audioStream)
+	{
+		return audioStream->internalCallback(input, output, frameCount, statusFlags);
+	}
+
+
+	AudioStream::AudioStream(uint64_t frameCount) : AudioStream(AudioDevice::getDefaultInputDeviceIndex(), AudioDevice::getDefaultOutputDeviceIndex(), frameCount)
+	{
+	}
+
+	AudioStream::AudioStream(int inputDeviceIndex, int outputDeviceIndex, uint64_t frameCount) : SoundBase(),
+		_stream(nullptr),
+		_frameCount(frameCount),
+		_outputChannelCount(0),
+		_inputSampleFormat(SampleFormat::Int32),
+		_outputSampleFormat(SampleFormat::Int32),
+		_inputConverter(),
+		_outputConverter(),
+		_processCallback(),
+		_block(nullptr),
+		_blockTime(0),
+		_inputSamples(),
+		_outputSamples(),
+		_monitor()
+	{
+		assert(_frameCount > 0);
+
+		// Take a reference on PortAudio, initialized once by the device registry
+
+		if (!_crz::acquirePortAudio())
+		{
+			return;
+		}
+
+		// Both sides run at the output frequency, the input device must support it for the stream to open
+
+		const PaDeviceInfo* inputInfo = Pa_GetDeviceInfo(inputDeviceIndex);
+		const PaDeviceInfo* outputInfo = Pa_GetDeviceInfo(outputDeviceIndex);
+		_frequency = outputInfo->defaultSampleRate;
+		_channelCount = inputInfo->maxInputChannels;
+		_outputChannelCount = outputInfo->maxOutputChannels;
+		_sampleCount = 0;
+		_currentSample = 0;
+		assert(_channelCount > 0);
+		assert(_outputChannelCount > 0);
+
+		_inputSampleFormat = AudioDevice::getNativeSampleFormat(inputDeviceIndex, true, _channelCount, _frequency);
+		_outputSampleFormat = AudioDevice::getNativeSampleFormat(outputDeviceIndex, false, _outputChannelCount, _frequency);
+		_inputConverter = SampleConverter(_inputSampleFormat);
+		_outputConverter = SampleConverter(_outputSampleFormat);
+
+		if (_inputSampleFormat != SampleFormat::Int32)
+		{
+			_inputSamples.resize(_frameCount * _channelCount);
+		}
+
+		if (_outputSampleFormat != SampleFormat::Int32)
+		{
+			_outputSamples.resize(_frameCount * _outputChannelCount);
+		}
+
+		// Open input and output in a single stream so that both blocks are delivered to the same callback
+
+		PaStreamParameters inputParameters;
+		inputParameters.device = inputDeviceIndex;
+		inputParameters.channelCount = _channelCount;
+		inputParameters.sampleFormat = _crz::toPaSampleFormat(_inputSampleFormat);
+		inputParameters.suggestedLatency = inputInfo->defaultLowInputLatency;
+		inputParameters.hostApiSpecificStreamInfo = nullptr;
+
+		PaStreamParameters outputParameters;
+		outputParameters.device = outputDeviceIndex;
+		outputParameters.channelCount = _outputChannelCount;
+		outputParameters.sampleFormat = _crz::toPaSampleFormat(_outputSampleFormat);
+		outputParameters.suggestedLatency = outputInfo->defaultLowOutputLatency;
+		outputParameters.hostApiSpecificStreamInfo = nullptr;
+
+		PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+		PaError error = Pa_OpenStream(&paStream, &inputParameters, &outputParameters, _frequency, _frameCount, paNoFlag, audioStreamCallback, this);
+		if (error)
+		{
+			_crz::releasePortAudio();
+			return;
+		}
+
+		_stream = reinterpret_cast<void*>(paStream);
+	}
+
+	void AudioStream::setProcessCallback(const ProcessCallback& callback)
+	{
+		assert(isValid());
+		assert(!isActive());
+
+		_processCallback = callback;
+	}
+
+	bool AudioStream::start()
+	{
+		assert(isValid());
+
+		return Pa_StartStream(reinterpret_cast<PaStream*>(_stream)) == paNoError;
+	}
+
+	void AudioStream::stop()
+	{
+		assert(isValid());
+
+		Pa_StopStream(reinterpret_cast<PaStream*>(_stream));
+	}
+
+	bool AudioStream::isActive() const
+	{
+		assert(isValid());
+
+		return Pa_IsStreamActive(reinterpret_cast<PaStream*>(_stream)) == 1;
+	}
+
+	uint16_t AudioStream::getOutputChannelCount() const
+	{
+		assert(isValid());
+
+		return _outputChannelCount;
+	}
+
+	uint64_t AudioStream::getFrameCount() const
+	{
+		assert(isValid());
+
+		return _frameCount;
+	}
+
+	SampleFormat AudioStream::getInputSampleFormat() const
+	{
+		assert(isValid());
+
+		return _inputSampleFormat;
+	}
+
+	SampleFormat AudioStream::getOutputSampleFormat() const
+	{
+		assert(isValid());
+
+		return _outputSampleFormat;
+	}
+
+	double AudioStream::getLatency() const
+	{
+		assert(isValid());
+
+		const PaStreamInfo* info = Pa_GetStreamInfo(reinterpret_cast<PaStream*>(_stream));
+
+		return info->inputLatency + info->outputLatency;
+	}
+
+	StreamStatistics AudioStream::getStatistics() const
+	{
+		assert(isValid());
+
+		return _monitor.getStatistics(_stream);
+	}
+
+	bool AudioStream::isValid() const
+	{
+		return _stream;
+	}
+
+	int AudioStream::internalCallback(const void* input, void* output, unsigned long frameCount, unsigned long statusFlags)
+	{
+		assert(frameCount <= _frameCount);
+
+		const TraceSpan span("AudioStream::internalCallback", _sampleCount);
+		const std::chrono::steady_clock::time_point blockStart = std::chrono::steady_clock::now();
+
+		_monitor.addCallback(statusFlags);
+
+		// Expose the input block as the samples of the sound, converted from the device format if needed
+
+		_block = reinterpret_cast<const int32_t*>(input);
+		if (_inputSampleFormat != SampleFormat::Int32)
+		{
+			_inputConverter.decode(_inputSamples.data(), input, frameCount * _channelCount);
+			_block = _inputSamples.data();
+		}
+
+		_blockTime = _sampleCount;
+		_sampleCount += frameCount;
+
+		// Process the block with the user callback, or pull it through the filters
+
+		int32_t* samples = _outputSampleFormat == SampleFormat::Int32 ? reinterpret_cast<int32_t*>(output) : _outputSamples.data();
+
+		if (_processCallback)
+		{
+			_processCallback(_block, samples, frameCount);
+		}
+		else
+		{
+			getFilteredSource()->getSamples(_frequency, _outputChannelCount, samples, _blockTime, _sampleCount);
+		}
+
+		_currentSample = _sampleCount;
+
+		if (_outputSampleFormat != SampleFormat::Int32)
+		{
+			_outputConverter.encode(output, samples, frameCount * _outputChannelCount);
+		}
+
+		_monitor.addBlockRenderTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count());
+
+		return paContinue;
+	}
+
+	void AudioStream::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
+	{
+		// Only the current block is available, anything outside of it is silence
+
+		const uint64_t sampleCount = _sampleCount;
+		const uint64_t from = std::clamp(timeFrom, _blockTime, sampleCount);
+		const uint64_t to = std::clamp(timeTo, _blockTime, sampleCount);
+
+		std::fill_n(samples, (from - timeFrom) * _channelCount, 0);
+		std::copy_n(_block + (from - _blockTime) * _channelCount, (to - from) * _channelCount, samples + (from - timeFrom) * _channelCount);
+		std::fill_n(samples + (to - timeFrom) * _channelCount, (timeTo - to) * _channelCount, 0);
+	}
+
+	AudioStream::~AudioStream()
+	{
+		if (isValid())
+		{
+			PaStream* paStream = reinterpret_cast<PaStream*>(_stream);
+
+			Pa_AbortStream(paStream);
+			Pa_CloseStream(paStream);
+			_crz::releasePortAudio();
+		}
+	}
+}
@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	AutomationLane::AutomationLane(float defaultValue) :
+		_defaultValue(defaultValue),
+		_points()
+	{
+	}
+
+	void AutomationLane::addPoint(uint64_t time, float value, AutomationCurve curve)
+	{
+		auto it = std::upper_bound(_points.begin(), _points.end(), time, [](uint64_t t, const Point& point) { return t < point.time; });
+		_points.insert(it, { time, value, curve });
+	}
+
+	void AutomationLane::discardBefore(uint64_t time)
+	{
+		// The last point before `time` is kept, it still defines the value of the current segment
+
+		while (_points.size() > 1 && _points[1].time <= time)
+		{
+			_defaultValue = _points.front().value;
+			_points.pop_front();
+		}
+	}
+
+	void AutomationLane::clear()
+	{
+		if (!_points.empty())
+		{
+			_defaultValue = _points.back().value;
+			_points.clear();
+		}
+	}
+
+	bool AutomationLane::render(float* values, uint64_t timeFrom, uint64_t frameCount, float& constantValue) const
+	{
+		// Each point ends a segment started by the previous one, with the shape given by its curve. Before the first
+		// point the lane holds its default value and after the last one it holds the last value.
+
+		if (_points.empty())
+		{
+			constantValue = _defaultValue;
+			return true;
+		}
+
+		const uint64_t timeTo = timeFrom + frameCount;
+
+		auto it = std::upper_bound(_points.begin(), _points.end(), timeFrom, [](uint64_t t, const Point& point) { return t < point.time; });
+		const auto itBegin = _points.cbegin();
+		const auto itEnd = _points.cend();
+
+		if (it == itEnd)
+		{
+			constantValue = _points.back().value;
+			return true;
+		}
+
+		if (timeTo <= it->time)
+		{
+			if (it == itBegin)
+			{
+				constantValue = _defaultValue;
+				return true;
+			}
+			else if (it->curve == AutomationCurve::Step || (it - 1)->value == it->value)
+			{
+				constantValue = (it - 1)->value;
+				return true;
+			}
+		}
+
+		// The range crosses at least one change, write the segments one by one
+
+		uint64_t time = timeFrom;
+		float* itValues = values;
+		while (time < timeTo)
+		{
+			if (it == itEnd)
+			{
+				_crz::fillRamp(itValues, timeTo - time, _points.back().value, 0.f);
+				break;
+			}
+
+			const uint64_t segmentEnd = std::min(timeTo, it->time);
+			const uint64_t count = segmentEnd - time;
+
+			if (it == itBegin)
+			{
+				_crz::fillRamp(itValues, count, _defaultValue, 0.f);
+			}
+			else
+			{
+				const Point& previous = *(it - 1);
+				const float length = static_cast<float>(it->time - previous.time);
+				const float x = static_cast<float>(time - previous.time);
+
+				switch (it->curve)
+				{
+					case AutomationCurve::Step:
+					{
+						_crz::fillRamp(itValues, count, previous.value, 0.f);
+						break;
+					}
+					case AutomationCurve::Exponential:
+					{
+						if (previous.value > 0.f && it->value > 0.f)
+						{
+							const float logStep = std::log(it->value / previous.value) / length;
+							_crz::fillExponential(itValues, count, previous.value, logStep * x, logStep);
+							break;
+						}
+
+						[[fallthrough]];
+					}
+					case AutomationCurve::Linear:
+					{
+						const float step = (it->value - previous.value) / length;
+						_crz::fillRamp(itValues, count, previous.value + step * x, step);
+						break;
+					}
+				}
+			}
+
+			itValues += count;
+			time = segmentEnd;
+			++it;
+		}
+
+		return false;
+	}
+
+	float AutomationLane::getValue(uint64_t time) const
+	{
+		float value;
+		render(&value, time, 1, value);
+
+		return value;
+	}
+}
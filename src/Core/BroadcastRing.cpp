@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	uint64_t BroadcastView::getFrameCount() const
+	{
+		return frameCounts[0] + frameCounts[1];
+	}
+
+	BroadcastRing::BroadcastRing(uint64_t frameCount, uint16_t channelCount) :
+		_mask(std::bit_ceil(frameCount) - 1),
+		_channelCount(channelCount),
+		_samples((_mask + 1) * channelCount, 0),
+		_writePosition(0),
+		_overwritePosition(0)
+	{
+		assert(frameCount > 0);
+		assert(channelCount > 0);
+	}
+
+	void BroadcastRing::write(const int32_t* samples, uint64_t frameCount)
+	{
+		assert(frameCount <= _mask + 1);
+
+		// Announce the frames about to be overwritten before touching them, readers check it after reading (seqlock)
+
+		const uint64_t writePosition = _writePosition.load(std::memory_order_relaxed);
+		_overwritePosition.store(writePosition + frameCount, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		const uint64_t index = writePosition & _mask;
+		const uint64_t firstCount = std::min(frameCount, _mask + 1 - index);
+		std::copy_n(samples, firstCount * _channelCount, _samples.data() + index * _channelCount);
+		std::copy_n(samples + firstCount * _channelCount, (frameCount - firstCount) * _channelCount, _samples.data());
+
+		_writePosition.store(writePosition + frameCount, std::memory_order_release);
+	}
+
+	bool BroadcastRing::copy(uint64_t position, uint64_t frameCount, int32_t* samples) const
+	{
+		// Frames not written yet or already too old are replaced by silence
+
+		const uint64_t writePosition = _writePosition.load(std::memory_order_acquire);
+		const uint64_t readablePosition = writePosition - std::min(writePosition, getReadableFrameCount());
+
+		const uint64_t from = std::clamp(position, readablePosition, writePosition);
+		const uint64_t to = std::clamp(position + frameCount, readablePosition, writePosition);
+
+		std::fill_n(samples, (from - position) * _channelCount, 0);
+		for (uint64_t i = from; i < to;)
+		{
+			const uint64_t index = i & _mask;
+			const uint64_t count = std::min(to - i, _mask + 1 - index);
+			std::copy_n(_samples.data() + index * _channelCount, count * _channelCount, samples + (i - position) * _channelCount);
+			i += count;
+		}
+		std::fill_n(samples + (to - position) * _channelCount, (position + frameCount - to) * _channelCount, 0);
+
+		return from == position && to == position + frameCount && isIntact(from);
+	}
+
+	uint64_t BroadcastRing::getWritePosition() const
+	{
+		return _writePosition.load(std::memory_order_acquire);
+	}
+
+	uint64_t BroadcastRing::getReadableFrameCount() const
+	{
+		// A quarter of the ring is left to the writer so that readers have time to use what they acquired
+
+		return (_mask + 1) - (_mask + 1) / 4;
+	}
+
+	uint64_t BroadcastRing::getCapacity() const
+	{
+		return _mask + 1;
+	}
+
+	uint16_t BroadcastRing::getChannelCount() const
+	{
+		return _channelCount;
+	}
+
+	bool BroadcastRing::isIntact(uint64_t position) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		return _overwritePosition.load(std::memory_order_relaxed) <= position + _mask + 1;
+	}
+
+	BroadcastReader::BroadcastReader(const BroadcastRing& ring) :
+		_ring(&ring),
+		_position(ring.getWritePosition()),
+		_skippedFrameCount(0)
+	{
+	}
+
+	BroadcastView BroadcastReader::acquire(uint64_t maxFrameCount)
+	{
+		// A reader too far behind the writer is moved forward instead of blocking it
+
+		const uint64_t writePosition = _ring->getWritePosition();
+		const uint64_t readableFrameCount = _ring->getReadableFrameCount();
+		if (writePosition - _position > readableFrameCount)
+		{
+			_skippedFrameCount += writePosition - readableFrameCount - _position;
+			_position = writePosition - readableFrameCount;
+		}
+
+		// The view points directly in the ring, in two parts when it wraps around
+
+		const uint64_t frameCount = std::min(maxFrameCount, writePosition - _position);
+		const uint64_t index = _position & _ring->_mask;
+		const uint64_t firstCount = std::min(frameCount, _ring->_mask + 1 - index);
+
+		BroadcastView view;
+		view.position = _position;
+		view.samples = { _ring->_samples.data() + index * _ring->_channelCount, _ring->_samples.data() };
+		view.frameCounts = { firstCount, frameCount - firstCount };
+
+		return view;
+	}
+
+	bool BroadcastReader::release(const BroadcastView& view)
+	{
+		assert(view.position == _position);
+
+		_position += view.getFrameCount();
+
+		return _ring->isIntact(view.position);
+	}
+
+	uint64_t BroadcastReader::getAvailableFrameCount() const
+	{
+		return std::min(_ring->getWritePosition() - _position, _ring->getReadableFrameCount());
+	}
+
+	uint64_t BroadcastReader::getPosition() const
+	{
+		return _position;
+	}
+
+	uint64_t BroadcastReader::getSkippedFrameCount() const
+	{
+		return _skippedFrameCount;
+	}
+}
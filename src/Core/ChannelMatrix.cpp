@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	namespace
+	{
+		// Channel orders are the ones of WAVE files and of most host APIs
+
+		constexpr Speaker monoLayout[] = { Speaker::FrontCenter };
+		constexpr Speaker stereoLayout[] = { Speaker::FrontLeft, Speaker::FrontRight };
+		constexpr Speaker surround30Layout[] = { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter };
+		constexpr Speaker quadLayout[] = { Speaker::FrontLeft, Speaker::FrontRight, Speaker::BackLeft, Speaker::BackRight };
+		constexpr Speaker surround50Layout[] = { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::BackLeft, Speaker::BackRight };
+		constexpr Speaker surround51Layout[] = { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LowFrequency, Speaker::BackLeft, Speaker::BackRight };
+		constexpr Speaker surround71Layout[] = { Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::LowFrequency, Speaker::BackLeft, Speaker::BackRight, Speaker::SideLeft, Speaker::SideRight };
+
+		constexpr float minus3dB = 0.70710678f;
+
+		int32_t findSpeaker(const Speaker* speakers, uint16_t speakerCount, Speaker speaker)
+		{
+			const Speaker* it = std::find(speakers, speakers + speakerCount, speaker);
+			return it == speakers + speakerCount ? -1 : static_cast<int32_t>(it - speakers);
+		}
+	}
+
+	ChannelMatrix::ChannelMatrix() : ChannelMatrix(1, 1)
+	{
+	}
+
+	ChannelMatrix::ChannelMatrix(uint16_t inputChannelCount, uint16_t outputChannelCount) :
+		_inputChannelCount(inputChannelCount),
+		_outputChannelCount(outputChannelCount),
+		_coefficients(inputChannelCount * outputChannelCount, 0.f),
+
+		_kind(Kind::Dense),
+		_sources(outputChannelCount, 0),
+		_gains(outputChannelCount, 0.f)
+	{
+		assert(inputChannelCount != 0);
+		assert(outputChannelCount != 0);
+
+		const Speaker* inputSpeakers;
+		const Speaker* outputSpeakers;
+
+		if (inputChannelCount != outputChannelCount && getStandardLayout(inputChannelCount, inputSpeakers) && getStandardLayout(outputChannelCount, outputSpeakers))
+		{
+			// Down and up mixes between known layouts, with the coefficients of ITU-R BS.775
+
+			for (uint16_t i = 0; i < inputChannelCount; ++i)
+			{
+				addStandardCoefficient(outputSpeakers, inputSpeakers[i], i, 1.f);
+			}
+		}
+		else
+		{
+			// Otherwise channels are kept in order, extra input channels are dropped and missing ones are duplicated
+
+			for (uint16_t i = 0; i < outputChannelCount; ++i)
+			{
+				_coefficients[i * inputChannelCount + i % inputChannelCount] = 1.f;
+			}
+		}
+
+		updateKind();
+	}
+
+	ChannelMatrix::ChannelMatrix(uint16_t inputChannelCount, uint16_t outputChannelCount, const float* coefficients) :
+		_inputChannelCount(inputChannelCount),
+		_outputChannelCount(outputChannelCount),
+		_coefficients(coefficients, coefficients + inputChannelCount * outputChannelCount),
+
+		_kind(Kind::Dense),
+		_sources(outputChannelCount, 0),
+		_gains(outputChannelCount, 0.f)
+	{
+		assert(inputChannelCount != 0);
+		assert(outputChannelCount != 0);
+
+		updateKind();
+	}
+
+	bool ChannelMatrix::getStandardLayout(uint16_t channelCount, const Speaker*& speakers)
+	{
+		switch (channelCount)
+		{
+			case 1:
+				speakers = monoLayout;
+				return true;
+			case 2:
+				speakers = stereoLayout;
+				return true;
+			case 3:
+				speakers = surround30Layout;
+				return true;
+			case 4:
+				speakers = quadLayout;
+				return true;
+			case 5:
+				speakers = surround50Layout;
+				return true;
+			case 6:
+				speakers = surround51Layout;
+				return true;
+			case 8:
+				speakers = surround71Layout;
+				return true;
+			default:
+				speakers = nullptr;
+				return false;
+		}
+	}
+
+	void ChannelMatrix::setCoefficient(uint16_t outputChannel, uint16_t inputChannel, float coefficient)
+	{
+		assert(outputChannel < _outputChannelCount);
+		assert(inputChannel < _inputChannelCount);
+
+		_coefficients[outputChannel * _inputChannelCount + inputChannel] = coefficient;
+		updateKind();
+	}
+
+	float ChannelMatrix::getCoefficient(uint16_t outputChannel, uint16_t inputChannel) const
+	{
+		assert(outputChannel < _outputChannelCount);
+		assert(inputChannel < _inputChannelCount);
+
+		return _coefficients[outputChannel * _inputChannelCount + inputChannel];
+	}
+
+	uint16_t ChannelMatrix::getInputChannelCount() const
+	{
+		return _inputChannelCount;
+	}
+
+	uint16_t ChannelMatrix::getOutputChannelCount() const
+	{
+		return _outputChannelCount;
+	}
+
+	bool ChannelMatrix::isIdentity() const
+	{
+		return _kind == Kind::Identity;
+	}
+
+	bool ChannelMatrix::isSparse() const
+	{
+		return _kind != Kind::Dense;
+	}
+
+	void ChannelMatrix::apply(int32_t* output, const int32_t* input, uint64_t frameCount) const
+	{
+		switch (_kind)
+		{
+			case Kind::Identity:
+				std::copy_n(input, frameCount * _inputChannelCount, output);
+				break;
+			case Kind::Sparse:
+				_crz::routeChannels<false>(output, input, frameCount, _outputChannelCount, _inputChannelCount, _sources.data(), _gains.data(), 0, 0, 1, 0);
+				break;
+			case Kind::Dense:
+				_crz::mixChannels<false>(output, input, frameCount, _outputChannelCount, _inputChannelCount, _coefficients.data(), 0, 0, 1, 0);
+				break;
+		}
+	}
+
+	void ChannelMatrix::applyResampled(int32_t* output, const int32_t* input, uint64_t inputFrameCount, uint64_t frameCount, uint64_t position, uint64_t step, uint64_t denominator) const
+	{
+		assert(inputFrameCount != 0);
+		assert(denominator != 0);
+
+		switch (_kind)
+		{
+			case Kind::Identity:
+				_crz::resampleChannels(output, input, frameCount, _inputChannelCount, position, step, denominator, inputFrameCount - 1);
+				break;
+			case Kind::Sparse:
+				_crz::routeChannels<true>(output, input, frameCount, _outputChannelCount, _inputChannelCount, _sources.data(), _gains.data(), position, step, denominator, inputFrameCount - 1);
+				break;
+			case Kind::Dense:
+				_crz::mixChannels<true>(output, input, frameCount, _outputChannelCount, _inputChannelCount, _coefficients.data(), position, step, denominator, inputFrameCount - 1);
+				break;
+		}
+	}
+
+	void ChannelMatrix::addStandardCoefficient(const Speaker* outputSpeakers, Speaker speaker, uint16_t inputChannel, float coefficient)
+	{
+		const int32_t outputChannel = findSpeaker(outputSpeakers, _outputChannelCount, speaker);
+		if (outputChannel != -1)
+		{
+			_coefficients[outputChannel * _inputChannelCount + inputChannel] += coefficient;
+			return;
+		}
+
+		// Speakers missing from the output layout are folded into the closest ones. A mono input is duplicated as is,
+		// the low frequency channel is dropped.
+
+		const bool hasCenter = findSpeaker(outputSpeakers, _outputChannelCount, Speaker::FrontCenter) != -1;
+		const bool hasFront = findSpeaker(outputSpeakers, _outputChannelCount, Speaker::FrontLeft) != -1;
+		const bool hasBack = findSpeaker(outputSpeakers, _outputChannelCount, Speaker::BackLeft) != -1;
+		const bool hasSide = findSpeaker(outputSpeakers, _outputChannelCount, Speaker::SideLeft) != -1;
+
+		switch (speaker)
+		{
+			case Speaker::FrontLeft:
+			case Speaker::FrontRight:
+				if (hasCenter)
+				{
+					addStandardCoefficient(outputSpeakers, Speaker::FrontCenter, inputChannel, coefficient * minus3dB);
+				}
+				break;
+			case Speaker::FrontCenter:
+				if (hasFront)
+				{
+					const float gain = _inputChannelCount == 1 ? coefficient : coefficient * minus3dB;
+					addStandardCoefficient(outputSpeakers, Speaker::FrontLeft, inputChannel, gain);
+					addStandardCoefficient(outputSpeakers, Speaker::FrontRight, inputChannel, gain);
+				}
+				break;
+			case Speaker::BackLeft:
+			case Speaker::BackRight:
+			{
+				const bool left = speaker == Speaker::BackLeft;
+				if (hasSide)
+				{
+					addStandardCoefficient(outputSpeakers, left ? Speaker::SideLeft : Speaker::SideRight, inputChannel, coefficient);
+				}
+				else
+				{
+					addStandardCoefficient(outputSpeakers, left ? Speaker::FrontLeft : Speaker::FrontRight, inputChannel, coefficient * minus3dB);
+				}
+				break;
+			}
+			case Speaker::SideLeft:
+			case Speaker::SideRight:
+			{
+				const bool left = speaker == Speaker::SideLeft;
+				if (hasBack)
+				{
+					addStandardCoefficient(outputSpeakers, left ? Speaker::BackLeft : Speaker::BackRight, inputChannel, coefficient);
+				}
+				else
+				{
+					addStandardCoefficient(outputSpeakers, left ? Speaker::FrontLeft : Speaker::FrontRight, inputChannel, coefficient * minus3dB);
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	void ChannelMatrix::updateKind()
+	{
+		// Matrices with at most one coefficient per output channel are routings: each output channel reads a single
+		// input channel with a gain. An identity routing is a copy.
+
+		bool sparse = true;
+		bool identity = _inputChannelCount == _outputChannelCount;
+
+		for (uint16_t i = 0; i < _outputChannelCount; ++i)
+		{
+			const float* itRow = _coefficients.data() + i * _inputChannelCount;
+
+			_sources[i] = 0;
+			_gains[i] = 0.f;
+
+			uint16_t nonZeroCount = 0;
+			for (uint16_t j = 0; j < _inputChannelCount; ++j)
+			{
+				if (itRow[j] != 0.f)
+				{
+					_sources[i] = j;
+					_gains[i] = itRow[j];
+					++nonZeroCount;
+				}
+			}
+
+			sparse = sparse && nonZeroCount <= 1;
+			identity = identity && nonZeroCount == 1 && _sources[i] == i && _gains[i] == 1.f;
+		}
+
+		if (identity)
+		{
+			_kind = Kind::Identity;
+		}
+		else if (sparse)
+		{
+			_kind = Kind::Sparse;
+		}
+		else
+		{
+			_kind = Kind::Dense;
+		}
+	}
+}
@@ -0,0 +1,427 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	EchoCanceller::EchoCanceller(const BroadcastRing& reference, uint32_t frequency, uint16_t channelCount, double filterLength, double maxDelay, uint64_t blockSize) :
+		_reader(reference),
+		_frequency(frequency),
+		_channelCount(channelCount),
+		_referenceChannelCount(reference.getChannelCount()),
+		_blockSize(blockSize),
+		_binCount(blockSize + 1),
+		_partitionCount(std::max<uint64_t>(std::ceil(filterLength * frequency / blockSize), 1)),
+		_delaySize(std::max<uint64_t>(std::bit_ceil<uint64_t>(2 * std::ceil(maxDelay * frequency)), 2 * blockSize)),
+
+		_fft(nullptr),
+		_delayFft(nullptr),
+
+		_referenceHistory(),
+		_referenceEnd(reference.getWritePosition()),
+		_referencePosition(0.0),
+		_synchronized(false),
+
+		_referenceReals(_partitionCount * _binCount),
+		_referenceImags(_partitionCount * _binCount),
+		_referenceHead(0),
+		_referencePowers(_binCount),
+		_stepSizes(_binCount),
+		_weightReals(channelCount * _partitionCount * _binCount),
+		_weightImags(channelCount * _partitionCount * _binCount),
+		_constraintPartition(0),
+
+		_captureBlock(blockSize),
+		_errorBlock(blockSize),
+		_timeBlock(2 * blockSize),
+		_echoReals(_binCount),
+		_echoImags(_binCount),
+		_errorReals(_binCount),
+		_errorImags(_binCount),
+		_fftScratch(2 * blockSize),
+
+		_delayCapture(_delaySize / 2),
+		_delayCaptureFrameCount(0),
+		_delayInput(_delaySize),
+		_delayCaptureReals(_delaySize / 2 + 1),
+		_delayCaptureImags(_delaySize / 2 + 1),
+		_delayReferenceReals(_delaySize / 2 + 1),
+		_delayReferenceImags(_delaySize / 2 + 1),
+		_crossReals(_delaySize / 2 + 1),
+		_crossImags(_delaySize / 2 + 1),
+		_delayScratch(_delaySize),
+		_delay(0),
+		_candidateDelay(0),
+
+		_captureEnergy(0.f),
+		_errorEnergy(0.f),
+
+		_sharedDelay(0),
+		_echoReturnLossEnhancement(0.f),
+		_resetRequested(false)
+	{
+		assert(frequency != 0);
+		assert(channelCount != 0);
+		assert(blockSize >= 2 && std::has_single_bit(blockSize));
+		assert(filterLength > 0.0);
+		assert(maxDelay > 0.0);
+
+		_fft = new _crz::Fft(2 * blockSize);
+		_delayFft = new _crz::Fft(_delaySize);
+
+		// The history holds the reference downmixed to mono, for the delay estimation window and the filter behind it
+
+		_referenceHistory.resize(std::bit_ceil(2 * _delaySize + (_partitionCount + 2) * blockSize), 0.f);
+
+		clear();
+	}
+
+	void EchoCanceller::process(int32_t* samples, uint64_t frameCount)
+	{
+		assert(frameCount % _blockSize == 0);
+
+		const TraceSpan span("EchoCanceller::process", frameCount);
+
+		if (_resetRequested.load(std::memory_order_relaxed) && _resetRequested.exchange(false, std::memory_order_acquire))
+		{
+			clear();
+		}
+
+		updateReference(frameCount);
+
+		// Blocks are aligned on the reference position tracked for the end of the capture
+
+		const int64_t referencePosition = std::llround(_referencePosition);
+		for (uint64_t i = 0; i < frameCount; i += _blockSize)
+		{
+			processBlock(samples + i * _channelCount, referencePosition - static_cast<int64_t>(frameCount - i - _blockSize));
+		}
+
+		const float enhancement = 10.f * std::log10((_captureEnergy + 1e-20f) / (_errorEnergy + 1e-20f));
+
+		_sharedDelay.store(_delay, std::memory_order_relaxed);
+		_echoReturnLossEnhancement.store(enhancement, std::memory_order_relaxed);
+	}
+
+	void EchoCanceller::reset()
+	{
+		// The filter belongs to the capture thread, it is cleared there before the next block
+
+		_resetRequested.store(true, std::memory_order_release);
+	}
+
+	uint32_t EchoCanceller::getFrequency() const
+	{
+		return _frequency;
+	}
+
+	uint16_t EchoCanceller::getChannelCount() const
+	{
+		return _channelCount;
+	}
+
+	uint64_t EchoCanceller::getBlockSize() const
+	{
+		return _blockSize;
+	}
+
+	uint64_t EchoCanceller::getFilterFrameCount() const
+	{
+		return _partitionCount * _blockSize;
+	}
+
+	uint64_t EchoCanceller::getDelay() const
+	{
+		return _sharedDelay.load(std::memory_order_relaxed);
+	}
+
+	float EchoCanceller::getEchoReturnLossEnhancement() const
+	{
+		return _echoReturnLossEnhancement.load(std::memory_order_relaxed);
+	}
+
+	EchoCanceller::~EchoCanceller()
+	{
+		delete reinterpret_cast<_crz::Fft*>(_fft);
+		delete reinterpret_cast<_crz::Fft*>(_delayFft);
+	}
+
+	void EchoCanceller::updateReference(uint64_t frameCount)
+	{
+		const uint64_t mask = _referenceHistory.size() - 1;
+		const float scale = 1.f / (2147483648.f * _referenceChannelCount);
+
+		// Everything rendered since the last block is appended to the history. Frames the reader skipped or that were
+		// overwritten while being read are replaced by silence.
+
+		while (true)
+		{
+			const BroadcastView view = _reader.acquire(_referenceHistory.size() / 2);
+			const uint64_t viewFrameCount = view.getFrameCount();
+			if (viewFrameCount == 0)
+			{
+				break;
+			}
+
+			const uint64_t skippedFrameCount = std::min<uint64_t>(view.position - _referenceEnd, _referenceHistory.size());
+			for (uint64_t i = view.position - skippedFrameCount; i < view.position; ++i)
+			{
+				_referenceHistory[i & mask] = 0.f;
+			}
+
+			uint64_t position = view.position;
+			for (uint8_t i = 0; i < 2; ++i)
+			{
+				const int32_t* itSamples = view.samples[i];
+				for (uint64_t j = 0; j < view.frameCounts[i]; ++j, ++position)
+				{
+					float sum = 0.f;
+					for (uint16_t k = 0; k < _referenceChannelCount; ++k, ++itSamples)
+					{
+						sum += static_cast<float>(*itSamples);
+					}
+
+					_referenceHistory[position & mask] = sum * scale;
+				}
+			}
+
+			if (!_reader.release(view))
+			{
+				for (uint64_t i = view.position; i < position; ++i)
+				{
+					_referenceHistory[i & mask] = 0.f;
+				}
+			}
+
+			_referenceEnd = position;
+		}
+
+		// The output is rendered ahead of the capture by blocks of its own size, and both devices may drift. The
+		// position matching the end of the capture follows the rendered frames slowly, and jumps if they are too far.
+
+		const double expectedPosition = _referencePosition + frameCount;
+		const double deviation = static_cast<double>(_referenceEnd) - expectedPosition;
+
+		if (!_synchronized || std::abs(deviation) > _delaySize / 2)
+		{
+			_referencePosition = _referenceEnd;
+			_synchronized = true;
+			clear();
+		}
+		else
+		{
+			_referencePosition = expectedPosition + _positionTracking * deviation;
+		}
+	}
+
+	void EchoCanceller::readReference(float* output, int64_t endPosition, uint64_t frameCount) const
+	{
+		// Positions not rendered yet, or already out of the history, are silent
+
+		const uint64_t mask = _referenceHistory.size() - 1;
+		const int64_t referenceEnd = _referenceEnd;
+		const int64_t historyStart = referenceEnd - static_cast<int64_t>(_referenceHistory.size());
+
+		int64_t position = endPosition - static_cast<int64_t>(frameCount);
+		for (uint64_t i = 0; i < frameCount; ++i, ++position)
+		{
+			output[i] = position >= 0 && position >= historyStart && position < referenceEnd ? _referenceHistory[position & mask] : 0.f;
+		}
+	}
+
+	void EchoCanceller::processBlock(int32_t* samples, int64_t referencePosition)
+	{
+		const _crz::Fft* fft = reinterpret_cast<const _crz::Fft*>(_fft);
+		const uint64_t spectrumSize = _partitionCount * _binCount;
+
+		// The capture downmixed to mono feeds the delay estimation
+
+		std::fill_n(_captureBlock.data(), _blockSize, 0.f);
+		for (uint16_t i = 0; i < _channelCount; ++i)
+		{
+			_crz::deinterleave(_errorBlock.data(), samples + i, _blockSize, _channelCount, 1.f / (2147483648.f * _channelCount));
+			_crz::addInPlace(_captureBlock.data(), _errorBlock.data(), _blockSize);
+		}
+
+		std::copy_n(_captureBlock.data(), _blockSize, _delayCapture.data() + _delayCaptureFrameCount);
+		_delayCaptureFrameCount += _blockSize;
+
+		if (_delayCaptureFrameCount == _delayCapture.size())
+		{
+			estimateDelay(referencePosition);
+			_delayCaptureFrameCount = 0;
+		}
+
+		// The filter starts half a block before the estimated delay, so that the direct path is not cut
+
+		const int64_t offset = _delay > _blockSize / 2 ? _delay - _blockSize / 2 : 0;
+
+		readReference(_timeBlock.data(), referencePosition - offset, 2 * _blockSize);
+
+		_referenceHead = (_referenceHead + _partitionCount - 1) % _partitionCount;
+		float* referenceReals = _referenceReals.data() + _referenceHead * _binCount;
+		float* referenceImags = _referenceImags.data() + _referenceHead * _binCount;
+		fft->transform(referenceReals, referenceImags, _timeBlock.data(), _fftScratch.data());
+
+		// Steps are normalized by the power of the reference in each bin, and shared by the partitions
+
+		const float regularization = 1e-6f * 2 * _blockSize;
+
+		_crz::smoothPowers(_referencePowers.data(), referenceReals, referenceImags, _binCount, _powerSmoothing);
+		for (uint64_t i = 0; i < _binCount; ++i)
+		{
+			_stepSizes[i] = _stepSize / (_partitionCount * _referencePowers[i] + regularization);
+		}
+
+		for (uint16_t i = 0; i < _channelCount; ++i)
+		{
+			float* weightReals = _weightReals.data() + i * spectrumSize;
+			float* weightImags = _weightImags.data() + i * spectrumSize;
+
+			// The echo is the sum of the partitions applied to the reference blocks of matching age (overlap-save)
+
+			std::fill_n(_echoReals.data(), _binCount, 0.f);
+			std::fill_n(_echoImags.data(), _binCount, 0.f);
+
+			for (uint64_t j = 0; j < _partitionCount; ++j)
+			{
+				const uint64_t k = ((_referenceHead + j) % _partitionCount) * _binCount;
+				_crz::multiplyAccumulateSpectrum(_echoReals.data(), _echoImags.data(), weightReals + j * _binCount, weightImags + j * _binCount, _referenceReals.data() + k, _referenceImags.data() + k, _binCount);
+			}
+
+			fft->inverseTransform(_timeBlock.data(), _echoReals.data(), _echoImags.data(), _fftScratch.data());
+
+			_crz::deinterleave(_captureBlock.data(), samples + i, _blockSize, _channelCount, 1.f / 2147483648.f);
+			std::copy_n(_captureBlock.data(), _blockSize, _errorBlock.data());
+			_crz::subtractInPlace(_errorBlock.data(), _timeBlock.data() + _blockSize, _blockSize);
+
+			// A filter that adds energy has diverged, the capture is passed through and the filter starts over if
+			// it is far off
+
+			const float captureEnergy = _crz::sumSquares(_captureBlock.data(), _blockSize);
+			const float errorEnergy = _crz::sumSquares(_errorBlock.data(), _blockSize);
+
+			if (errorEnergy > captureEnergy)
+			{
+				_crz::interleave(samples + i, _captureBlock.data(), _blockSize, _channelCount, 2147483648.f);
+			}
+			else
+			{
+				_crz::interleave(samples + i, _errorBlock.data(), _blockSize, _channelCount, 2147483648.f);
+			}
+
+			_captureEnergy += (1.f - _energySmoothing) * (captureEnergy - _captureEnergy);
+			_errorEnergy += (1.f - _energySmoothing) * (std::min(errorEnergy, captureEnergy) - _errorEnergy);
+
+			if (errorEnergy > 4.f * captureEnergy + 1e-12f)
+			{
+				std::fill_n(weightReals, spectrumSize, 0.f);
+				std::fill_n(weightImags, spectrumSize, 0.f);
+				continue;
+			}
+
+			// Normalized LMS update of every partition with the error spectrum
+
+			std::fill_n(_timeBlock.data(), _blockSize, 0.f);
+			std::copy_n(_errorBlock.data(), _blockSize, _timeBlock.data() + _blockSize);
+			fft->transform(_errorReals.data(), _errorImags.data(), _timeBlock.data(), _fftScratch.data());
+
+			for (uint64_t j = 0; j < _partitionCount; ++j)
+			{
+				const uint64_t k = ((_referenceHead + j) % _partitionCount) * _binCount;
+				_crz::multiplyAccumulateConjugateSpectrum(weightReals + j * _binCount, weightImags + j * _binCount, _referenceReals.data() + k, _referenceImags.data() + k, _errorReals.data(), _errorImags.data(), _stepSizes.data(), _binCount);
+			}
+
+			// The updates are only constrained to a linear convolution for one partition per block, in turn
+
+			float* constrainedReals = weightReals + _constraintPartition * _binCount;
+			float* constrainedImags = weightImags + _constraintPartition * _binCount;
+
+			fft->inverseTransform(_timeBlock.data(), constrainedReals, constrainedImags, _fftScratch.data());
+			std::fill_n(_timeBlock.data() + _blockSize, _blockSize, 0.f);
+			fft->transform(constrainedReals, constrainedImags, _timeBlock.data(), _fftScratch.data());
+		}
+
+		_constraintPartition = (_constraintPartition + 1) % _partitionCount;
+	}
+
+	void EchoCanceller::estimateDelay(int64_t referencePosition)
+	{
+		// Generalized cross correlation with phase transform between the last half window of capture and the window
+		// of reference ending with it. The correlation at lag e is the capture delayed by half a window minus e.
+
+		const _crz::Fft* fft = reinterpret_cast<const _crz::Fft*>(_delayFft);
+		const uint64_t halfSize = _delaySize / 2;
+
+		readReference(_delayInput.data(), referencePosition, _delaySize);
+		if (_crz::sumSquares(_delayInput.data(), _delaySize) < 1e-8f * _delaySize)
+		{
+			return;
+		}
+
+		fft->transform(_delayReferenceReals.data(), _delayReferenceImags.data(), _delayInput.data(), _delayScratch.data());
+
+		std::copy_n(_delayCapture.data(), halfSize, _delayInput.data());
+		std::fill_n(_delayInput.data() + halfSize, halfSize, 0.f);
+		fft->transform(_delayCaptureReals.data(), _delayCaptureImags.data(), _delayInput.data(), _delayScratch.data());
+
+		_crz::smoothPhaseTransform(_crossReals.data(), _crossImags.data(), _delayCaptureReals.data(), _delayCaptureImags.data(), _delayReferenceReals.data(), _delayReferenceImags.data(), halfSize + 1, _phaseSmoothing);
+		fft->inverseTransform(_delayInput.data(), _crossReals.data(), _crossImags.data(), _delayScratch.data());
+
+		uint64_t peakLag = 1;
+		float peak = 0.f;
+		float sum = 0.f;
+		for (uint64_t i = 1; i <= halfSize; ++i)
+		{
+			sum += std::abs(_delayInput[i]);
+			if (_delayInput[i] > peak)
+			{
+				peak = _delayInput[i];
+				peakLag = i;
+			}
+		}
+
+		if (peak < _minPeakRatio * sum / halfSize)
+		{
+			return;
+		}
+
+		// A new delay is only taken once confirmed, the filter adapted to the previous one is then cleared
+
+		const uint64_t delay = halfSize - peakLag;
+		const uint64_t tolerance = _blockSize / 4;
+
+		if (std::max(delay, _candidateDelay) - std::min(delay, _candidateDelay) <= tolerance && std::max(delay, _delay) - std::min(delay, _delay) > tolerance)
+		{
+			_delay = delay;
+
+			std::fill(_weightReals.begin(), _weightReals.end(), 0.f);
+			std::fill(_weightImags.begin(), _weightImags.end(), 0.f);
+		}
+
+		_candidateDelay = delay;
+	}
+
+	void EchoCanceller::clear()
+	{
+		std::fill(_referenceReals.begin(), _referenceReals.end(), 0.f);
+		std::fill(_referenceImags.begin(), _referenceImags.end(), 0.f);
+		std::fill(_referencePowers.begin(), _referencePowers.end(), 0.f);
+		std::fill(_weightReals.begin(), _weightReals.end(), 0.f);
+		std::fill(_weightImags.begin(), _weightImags.end(), 0.f);
+		std::fill(_crossReals.begin(), _crossReals.end(), 0.f);
+		std::fill(_crossImags.begin(), _crossImags.end(), 0.f);
+
+		_delayCaptureFrameCount = 0;
+		_delay = 0;
+		_candidateDelay = 0;
+		_captureEnergy = 0.f;
+		_errorEnergy = 0.f;
+	}
+}
@@ -19,4 +19,22 @@ namespace crz
 	{
 		_source = source;
 	}
+
+	uint64_t FilterBase::getAvailableSampleCount() const
+	{
+		return _source->getAvailableSampleCount();
+	}
+
+	bool FilterBase::isSilent(uint64_t timeFrom, uint64_t timeTo) const
+	{
+		// A filter keeping the timing of its source and without tail is silent where its source is, the others must
+		// override this
+
+		return _source->isSilent(timeFrom, timeTo);
+	}
+
+	void FilterBase::setParameter(uint32_t parameter, const float* values, uint64_t valueCount)
+	{
+		// Filters without automatable parameters ignore automation
+	}
 }
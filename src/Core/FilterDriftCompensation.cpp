@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	FilterDriftCompensation::FilterDriftCompensation(double latency, double maxDeviation) : FilterBase(),
+		_latency(latency),
+		_maxDeviation(maxDeviation),
+
+		_currentSample(0),
+		_readPosition(0),
+		_primed(false),
+
+		_sourceSamples(),
+		_keptFrameCount(0),
+		_phase(0.0),
+
+		_fillEstimate(0.0),
+		_integral(0.0),
+		_ratio(1.0),
+		_measuredLatency(0.0),
+
+		_underrunCount(0),
+		_resyncCount(0)
+	{
+		assert(latency > 0.0);
+		assert(maxDeviation > 0.0 && maxDeviation < 1.0);
+	}
+
+	void FilterDriftCompensation::setLatency(double latency)
+	{
+		assert(latency > 0.0);
+
+		_latency.store(latency, std::memory_order_relaxed);
+	}
+
+	double FilterDriftCompensation::getLatency() const
+	{
+		return _latency.load(std::memory_order_relaxed);
+	}
+
+	double FilterDriftCompensation::getMeasuredLatency() const
+	{
+		return _measuredLatency.load(std::memory_order_relaxed);
+	}
+
+	double FilterDriftCompensation::getRatio() const
+	{
+		return _ratio.load(std::memory_order_relaxed);
+	}
+
+	uint64_t FilterDriftCompensation::getUnderrunCount() const
+	{
+		return _underrunCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t FilterDriftCompensation::getResyncCount() const
+	{
+		return _resyncCount.load(std::memory_order_relaxed);
+	}
+
+	uint32_t FilterDriftCompensation::getFrequency() const
+	{
+		return _source->getFrequency();
+	}
+
+	uint16_t FilterDriftCompensation::getChannelCount() const
+	{
+		return _source->getChannelCount();
+	}
+
+	uint64_t FilterDriftCompensation::getSampleCount() const
+	{
+		// The filter delays its source by the target latency, it thus ends that much after the last frame it can read
+
+		return _currentSample + getSourceFrameCount() + static_cast<uint64_t>(getLatency() * _source->getFrequency());
+	}
+
+	uint64_t FilterDriftCompensation::getCurrentSample() const
+	{
+		return _currentSample;
+	}
+
+	uint64_t FilterDriftCompensation::getAvailableSampleCount() const
+	{
+		return getSourceFrameCount();
+	}
+
+	bool FilterDriftCompensation::isSilent(uint64_t timeFrom, uint64_t timeTo) const
+	{
+		// The filter delays and resamples its source, its frames do not match those of the source
+
+		return false;
+	}
+
+	uint64_t FilterDriftCompensation::getSourceFrameCount() const
+	{
+		const uint64_t sourceEnd = _source->getCurrentSample() + _source->getAvailableSampleCount();
+
+		return sourceEnd > _readPosition ? sourceEnd - _readPosition : 0;
+	}
+
+	void FilterDriftCompensation::resetInterpolation()
+	{
+		_keptFrameCount = 0;
+		_phase = 0.0;
+	}
+
+	void FilterDriftCompensation::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
+	{
+		const TraceSpan span("FilterDriftCompensation::getRawSamples", timeFrom);
+
+		const uint32_t frequency = _source->getFrequency();
+		const uint16_t channelCount = _source->getChannelCount();
+		const uint64_t frameCount = timeTo - timeFrom;
+
+		_currentSample = timeTo;
+
+		const uint64_t targetFrameCount = std::max<uint64_t>(getLatency() * frequency, 1);
+
+		// Jump to the target latency when too far behind the source. This aligns the first read on a source that was
+		// already running, and recovers from a consumer that stalled.
+
+		uint64_t availableCount = getSourceFrameCount();
+		if (availableCount > 2 * targetFrameCount + frameCount)
+		{
+			_readPosition += availableCount - targetFrameCount;
+			availableCount = targetFrameCount;
+			_fillEstimate = targetFrameCount;
+			resetInterpolation();
+
+			if (_primed)
+			{
+				_resyncCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// Stay silent until the target latency is buffered
+
+		if (!_primed)
+		{
+			if (availableCount < targetFrameCount)
+			{
+				std::fill_n(samples, frameCount * channelCount, 0);
+				return;
+			}
+
+			_primed = true;
+			_fillEstimate = availableCount;
+		}
+
+		// PI loop on the smoothed fill level: the ratio is the number of source frames consumed per output frame. The
+		// smoothing removes the sawtooth due to the block sizes of both clocks, the integral term converges to their
+		// relative drift.
+
+		const double fill = availableCount + _keptFrameCount - _phase - 1.0;
+		_fillEstimate += (fill - _fillEstimate) * std::min(1.0, frameCount / (_smoothingTime * frequency));
+
+		const double error = (_fillEstimate - targetFrameCount) / frequency;
+		const double step = error * frameCount / frequency;
+
+		double ratio = 1.0 + _proportionalGain * error + _integralGain * (_integral + step);
+		if (std::abs(ratio - 1.0) < _maxDeviation)
+		{
+			_integral += step;
+		}
+		else
+		{
+			ratio = std::clamp(ratio, 1.0 - _maxDeviation, 1.0 + _maxDeviation);
+		}
+
+		_ratio.store(ratio, std::memory_order_relaxed);
+		_measuredLatency.store(_fillEstimate / frequency, std::memory_order_relaxed);
+
+		// Read the frames needed by the cubic interpolation of the block. Frame 0 of the buffer precedes the position
+		// of the first output frame, the frames kept from the previous block are at the beginning.
+
+		const uint64_t neededCount = static_cast<uint64_t>(1.0 + _phase + (frameCount - 1) * ratio) + 3;
+		const uint64_t readCount = neededCount - _keptFrameCount;
+
+		if (readCount > availableCount)
+		{
+			// The source starved: restart from silence rather than stretch what is left
+
+			std::fill_n(samples, frameCount * channelCount, 0);
+
+			_primed = false;
+			resetInterpolation();
+			_underrunCount.fetch_add(1, std::memory_order_relaxed);
+
+			return;
+		}
+
+		if (_sourceSamples.size() < neededCount * channelCount)
+		{
+			_sourceSamples.resize(neededCount * channelCount);
+		}
+
+		_source->getSamples(frequency, channelCount, _sourceSamples.data() + _keptFrameCount * channelCount, _readPosition, _readPosition + readCount);
+		_readPosition += readCount;
+
+		// Catmull-Rom interpolation, positions are recomputed from the block start to avoid accumulating errors
+
+		int32_t* itDst = samples;
+		for (uint64_t i = 0; i < frameCount; ++i)
+		{
+			const double x = 1.0 + _phase + i * ratio;
+			const uint64_t index = x;
+			const float t = static_cast<float>(x - index);
+
+			const int32_t* itSrc = _sourceSamples.data() + (index - 1) * channelCount;
+			for (uint16_t j = 0; j < channelCount; ++j, ++itDst, ++itSrc)
+			{
+				const float y0 = static_cast<float>(itSrc[0]);
+				const float y1 = static_cast<float>(itSrc[channelCount]);
+				const float y2 = static_cast<float>(itSrc[2 * channelCount]);
+				const float y3 = static_cast<float>(itSrc[3 * channelCount]);
+
+				const float c1 = y2 - y0;
+				const float c2 = 2.f * y0 - 5.f * y1 + 4.f * y2 - y3;
+				const float c3 = 3.f * (y1 - y2) + y3 - y0;
+
+				*itDst = _crz::floatToSample(y1 + 0.5f * t * (c1 + t * (c2 + t * c3)));
+			}
+		}
+
+		// Keep the frames the next block starts from
+
+		const double endPosition = 1.0 + _phase + frameCount * ratio;
+		const uint64_t endIndex = endPosition;
+
+		_keptFrameCount = neededCount - endIndex + 1;
+		_phase = endPosition - endIndex;
+		std::copy(_sourceSamples.begin() + (endIndex - 1) * channelCount, _sourceSamples.begin() + neededCount * channelCount, _sourceSamples.begin());
+	}
+}
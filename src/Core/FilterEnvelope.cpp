@@ -0,0 +1,349 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	FilterEnvelope::FilterEnvelope() : FilterEnvelope(0.0, 0.0, 1.0, 0.0)
+	{
+	}
+
+	FilterEnvelope::FilterEnvelope(double attack, double decay, double sustain, double release) : FilterBase(),
+		_attack(0.0),
+		_decay(0.0),
+		_sustain(1.0),
+		_release(0.0),
+		_releaseTime(-1.0),
+		_gainPoints(),
+
+		_envelopes(),
+		_controlEnvelope(0),
+		_pendingEnvelope(1),
+		_mixEnvelope(2),
+		_adsrGains(),
+		_automationGains(),
+		_parameterGains(1, 1.f),
+		_stretchedGains()
+	{
+		setAdsr(attack, decay, sustain, release);
+	}
+
+	void FilterEnvelope::setAdsr(double attack, double decay, double sustain, double release)
+	{
+		assert(attack >= 0.0);
+		assert(decay >= 0.0);
+		assert(sustain >= 0.0);
+		assert(release >= 0.0);
+
+		_attack = attack;
+		_decay = decay;
+		_sustain = sustain;
+		_release = release;
+
+		publishEnvelope();
+	}
+
+	void FilterEnvelope::setReleaseTime(double releaseTime)
+	{
+		_releaseTime = releaseTime;
+		publishEnvelope();
+	}
+
+	void FilterEnvelope::addGainPoint(double time, double gain)
+	{
+		assert(time >= 0.0);
+		assert(gain >= 0.0);
+
+		auto it = std::upper_bound(_gainPoints.begin(), _gainPoints.end(), time, [](double t, const std::pair<double, double>& point) { return t < point.first; });
+		_gainPoints.emplace(it, time, gain);
+
+		publishEnvelope();
+	}
+
+	void FilterEnvelope::clearGainPoints()
+	{
+		_gainPoints.clear();
+		publishEnvelope();
+	}
+
+	void FilterEnvelope::setParameter(uint32_t parameter, const float* values, uint64_t valueCount)
+	{
+		assert(parameter == GainParameter);
+		assert(valueCount != 0);
+
+		_parameterGains.assign(values, values + valueCount);
+	}
+
+	uint32_t FilterEnvelope::getFrequency() const
+	{
+		return _source->getFrequency();
+	}
+
+	uint16_t FilterEnvelope::getChannelCount() const
+	{
+		return _source->getChannelCount();
+	}
+
+	uint64_t FilterEnvelope::getSampleCount() const
+	{
+		return _source->getSampleCount();
+	}
+
+	uint64_t FilterEnvelope::getCurrentSample() const
+	{
+		return _source->getCurrentSample();
+	}
+
+	bool FilterEnvelope::renderBreakpoints(const std::vector<Breakpoint>& breakpoints, uint64_t timeFrom, uint64_t frameCount, float* gains, float& constantGain)
+	{
+		// Before the first and after the last breakpoint the gain is flat
+
+		if (breakpoints.empty())
+		{
+			constantGain = 1.f;
+			return true;
+		}
+
+		const uint64_t timeTo = timeFrom + frameCount;
+
+		if (timeTo <= breakpoints.front().time)
+		{
+			constantGain = breakpoints.front().gain;
+			return true;
+		}
+
+		if (timeFrom >= breakpoints.back().time)
+		{
+			constantGain = breakpoints.back().gain;
+			return true;
+		}
+
+		// Find the first breakpoint strictly after timeFrom, and shortcut if the whole range is on a flat segment
+
+		auto it = std::upper_bound(breakpoints.begin(), breakpoints.end(), timeFrom, [](uint64_t t, const Breakpoint& breakpoint) { return t < breakpoint.time; });
+		const auto itBegin = breakpoints.cbegin();
+		const auto itEnd = breakpoints.cend();
+
+		if (it != itBegin && timeTo <= it->time && (it - 1)->gain == it->gain)
+		{
+			constantGain = it->gain;
+			return true;
+		}
+
+		// Otherwise write the ramps segment by segment
+
+		uint64_t time = timeFrom;
+		float* itGains = gains;
+		while (time < timeTo)
+		{
+			if (it == itEnd)
+			{
+				_crz::fillRamp(itGains, timeTo - time, breakpoints.back().gain, 0.f);
+				break;
+			}
+
+			const uint64_t segmentEnd = std::min(timeTo, it->time);
+			const uint64_t count = segmentEnd - time;
+
+			if (it == itBegin)
+			{
+				_crz::fillRamp(itGains, count, it->gain, 0.f);
+			}
+			else
+			{
+				const Breakpoint& previous = *(it - 1);
+				const float step = (it->gain - previous.gain) / static_cast<float>(it->time - previous.time);
+				_crz::fillRamp(itGains, count, previous.gain + step * static_cast<float>(time - previous.time), step);
+			}
+
+			itGains += count;
+			time = segmentEnd;
+			++it;
+		}
+
+		return false;
+	}
+
+	void FilterEnvelope::publishEnvelope()
+	{
+		// The envelope is triple buffered: the control thread fills its copy and swaps it with the pending one, the
+		// mixing thread takes the pending one when it is new. Capacities are reserved here so that computing the
+		// breakpoints does not allocate on the mixing thread.
+
+		Envelope& envelope = _envelopes[_controlEnvelope];
+		envelope.attack = _attack;
+		envelope.decay = _decay;
+		envelope.sustain = _sustain;
+		envelope.release = _release;
+		envelope.releaseTime = _releaseTime;
+		envelope.gainPoints = _gainPoints;
+
+		envelope.breakpointsOutdated = true;
+		envelope.adsrBreakpoints.reserve(5);
+		envelope.gainBreakpoints.reserve(_gainPoints.size());
+
+		_controlEnvelope = _pendingEnvelope.exchange(_controlEnvelope | _newEnvelope, std::memory_order_acq_rel) & ~_newEnvelope;
+	}
+
+	void FilterEnvelope::computeBreakpoints(Envelope& envelope)
+	{
+		const double frequency = _source->getFrequency();
+		const uint64_t sampleCount = _source->getSampleCount();
+
+		// ADSR breakpoints - an identity envelope has none so that it costs nothing
+
+		std::vector<Breakpoint>& adsrBreakpoints = envelope.adsrBreakpoints;
+		adsrBreakpoints.clear();
+
+		const bool hasRelease = envelope.releaseTime >= 0.0 || (sampleCount != UINT64_MAX && envelope.release > 0.0);
+		if (envelope.attack > 0.0 || envelope.decay > 0.0 || envelope.sustain != 1.0 || hasRelease)
+		{
+			const uint64_t attackEnd = envelope.attack * frequency;
+			const uint64_t decayEnd = attackEnd + static_cast<uint64_t>(envelope.decay * frequency);
+			const uint64_t releaseLength = envelope.release * frequency;
+
+			adsrBreakpoints.push_back({ 0, attackEnd == 0 ? 1.f : 0.f });
+			adsrBreakpoints.push_back({ attackEnd, 1.f });
+			adsrBreakpoints.push_back({ decayEnd, static_cast<float>(envelope.sustain) });
+
+			if (hasRelease)
+			{
+				uint64_t releaseStart;
+				if (envelope.releaseTime >= 0.0)
+				{
+					releaseStart = envelope.releaseTime * frequency;
+				}
+				else
+				{
+					releaseStart = sampleCount > releaseLength ? sampleCount - releaseLength : 0;
+				}
+
+				// The release starts from the level reached at releaseStart, even if attack or decay were not over
+				// (a single frame is either written in the buffer or returned as constant, both are releaseGain)
+
+				float releaseGain;
+				renderBreakpoints(adsrBreakpoints, releaseStart, 1, &releaseGain, releaseGain);
+
+				while (!adsrBreakpoints.empty() && adsrBreakpoints.back().time >= releaseStart)
+				{
+					adsrBreakpoints.pop_back();
+				}
+
+				adsrBreakpoints.push_back({ releaseStart, releaseGain });
+				adsrBreakpoints.push_back({ releaseStart + releaseLength, 0.f });
+			}
+		}
+
+		// Gain automation breakpoints
+
+		envelope.gainBreakpoints.clear();
+		for (const std::pair<double, double>& point : envelope.gainPoints)
+		{
+			envelope.gainBreakpoints.push_back({ static_cast<uint64_t>(point.first * frequency), static_cast<float>(point.second) });
+		}
+
+		envelope.breakpointsOutdated = false;
+	}
+
+	void FilterEnvelope::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
+	{
+		const TraceSpan span("FilterEnvelope::getRawSamples", timeFrom);
+
+		_source->getSamples(_source->getFrequency(), _source->getChannelCount(), samples, timeFrom, timeTo);
+
+		// Silence stays silence whatever the gain
+
+		if (_source->isSilent(timeFrom, timeTo))
+		{
+			return;
+		}
+
+		if (_pendingEnvelope.load(std::memory_order_relaxed) & _newEnvelope)
+		{
+			_mixEnvelope = _pendingEnvelope.exchange(_mixEnvelope, std::memory_order_acq_rel) & ~_newEnvelope;
+		}
+
+		Envelope& envelope = _envelopes[_mixEnvelope];
+		if (envelope.breakpointsOutdated)
+		{
+			computeBreakpoints(envelope);
+		}
+
+		const uint64_t frameCount = timeTo - timeFrom;
+		const uint16_t channelCount = _source->getChannelCount();
+
+		if (_adsrGains.size() < frameCount)
+		{
+			_adsrGains.resize(frameCount);
+			_automationGains.resize(frameCount);
+			_stretchedGains.resize(frameCount);
+		}
+
+		// Render each gain source, constant ones are folded in a single scalar and the others in a single ramp
+
+		float gain = 1.f;
+		float* gains = nullptr;
+
+		const auto combine = [&](bool constant, float constantGain, float* buffer)
+		{
+			if (constant)
+			{
+				gain *= constantGain;
+			}
+			else if (!gains)
+			{
+				gains = buffer;
+			}
+			else
+			{
+				_crz::multiplyInPlace(gains, buffer, frameCount);
+			}
+		};
+
+		float constantGain;
+		combine(renderBreakpoints(envelope.adsrBreakpoints, timeFrom, frameCount, _adsrGains.data(), constantGain), constantGain, _adsrGains.data());
+		combine(renderBreakpoints(envelope.gainBreakpoints, timeFrom, frameCount, _automationGains.data(), constantGain), constantGain, _automationGains.data());
+
+		// Gain set by the output automation is given for the output block, stretch it on the block of the source
+
+		const uint64_t parameterCount = _parameterGains.size();
+		if (parameterCount == 1)
+		{
+			combine(true, _parameterGains.front(), nullptr);
+		}
+		else
+		{
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				_stretchedGains[i] = _parameterGains[i * parameterCount / frameCount];
+			}
+
+			combine(false, 1.f, _stretchedGains.data());
+		}
+
+		// Apply the result
+
+		if (!gains)
+		{
+			if (gain != 1.f)
+			{
+				_crz::applyGain(samples, frameCount * channelCount, gain);
+			}
+		}
+		else
+		{
+			if (gain != 1.f)
+			{
+				_crz::scaleInPlace(gains, gain, frameCount);
+			}
+
+			_crz::applyGainRamp(samples, frameCount, channelCount, gains);
+		}
+	}
+}
@@ -38,6 +38,8 @@ namespace crz
 
 	void FilterPlaySpeed::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
 	{
+		const TraceSpan span("FilterPlaySpeed::getRawSamples", timeFrom);
+
 		_source->getSamples(_source->getFrequency(), _source->getChannelCount(), samples, timeFrom, timeTo);
 	}
 }
@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	Limiter::Limiter(uint32_t frequency, uint16_t channelCount, float threshold, double lookAhead, double release) :
+		_frequency(frequency),
+		_channelCount(channelCount),
+		_threshold(0.f),
+		_release(0.0),
+		_latency(std::max<uint64_t>(std::llround(lookAhead * frequency), 1)),
+
+		_thresholdSample(0.f),
+		_releaseFactor(0.f),
+
+		_delayedSamples((_latency + _chunkFrameCount) * channelCount),
+		_peaks(_chunkFrameCount),
+		_gains(_chunkFrameCount),
+
+		_windowPositions(_latency + 2),
+		_windowGains(_latency + 2),
+		_windowBegin(0),
+		_windowEnd(0),
+		_position(0),
+
+		_releasedGain(1.f),
+		_smoothedGains(_latency),
+		_gainSum(0.0)
+	{
+		assert(frequency != 0);
+		assert(channelCount != 0);
+		assert(lookAhead >= 0.0);
+
+		setThreshold(threshold);
+		setRelease(release);
+		reset();
+	}
+
+	void Limiter::setThreshold(float threshold)
+	{
+		assert(threshold <= 0.f);
+
+		// The mix is in the scale of 32 bits samples
+
+		_threshold = threshold;
+		_thresholdSample = 2147483648.f * std::pow(10.f, threshold / 20.f);
+	}
+
+	float Limiter::getThreshold() const
+	{
+		return _threshold;
+	}
+
+	void Limiter::setRelease(double release)
+	{
+		assert(release > 0.0);
+
+		_release = release;
+		_releaseFactor = std::exp(-1.0 / (release * _frequency));
+	}
+
+	double Limiter::getRelease() const
+	{
+		return _release;
+	}
+
+	uint32_t Limiter::getFrequency() const
+	{
+		return _frequency;
+	}
+
+	uint16_t Limiter::getChannelCount() const
+	{
+		return _channelCount;
+	}
+
+	uint64_t Limiter::getLatency() const
+	{
+		return _latency;
+	}
+
+	void Limiter::process(float* mix, uint64_t frameCount)
+	{
+		const uint64_t delayedSampleCount = _latency * _channelCount;
+
+		for (uint64_t i = 0; i < frameCount; i += _chunkFrameCount)
+		{
+			const uint64_t chunkFrameCount = std::min(frameCount - i, _chunkFrameCount);
+			const uint64_t chunkSampleCount = chunkFrameCount * _channelCount;
+			float* chunk = mix + i * _channelCount;
+
+			// Gains are computed on the incoming frames and applied to the frames leaving the delay line
+
+			_crz::computeFramePeaks(_peaks.data(), chunk, chunkFrameCount, _channelCount);
+			for (uint64_t j = 0; j < chunkFrameCount; ++j)
+			{
+				_gains[j] = computeGain(_thresholdSample / std::max(_peaks[j], _thresholdSample));
+			}
+
+			std::copy_n(chunk, chunkSampleCount, _delayedSamples.data() + delayedSampleCount);
+			std::copy_n(_delayedSamples.data(), chunkSampleCount, chunk);
+			std::copy_n(_delayedSamples.data() + chunkSampleCount, delayedSampleCount, _delayedSamples.data());
+
+			_crz::applyFrameGains(chunk, _gains.data(), chunkFrameCount, _channelCount);
+		}
+	}
+
+	void Limiter::reset()
+	{
+		std::fill(_delayedSamples.begin(), _delayedSamples.end(), 0.f);
+		std::fill(_smoothedGains.begin(), _smoothedGains.end(), 1.f);
+
+		_windowBegin = 0;
+		_windowEnd = 0;
+		_position = 0;
+		_releasedGain = 1.f;
+		_gainSum = _latency;
+	}
+
+	float Limiter::computeGain(float requiredGain)
+	{
+		// The minimum of the required gains over the look-ahead window is kept in a monotonic deque. Each required
+		// gain stays in it until the frame it belongs to leaves the delay line.
+
+		const uint64_t windowSize = _windowGains.size();
+
+		while (_windowEnd != _windowBegin && _windowGains[(_windowEnd - 1) % windowSize] >= requiredGain)
+		{
+			--_windowEnd;
+		}
+
+		_windowGains[_windowEnd % windowSize] = requiredGain;
+		_windowPositions[_windowEnd % windowSize] = _position;
+		++_windowEnd;
+
+		if (_windowPositions[_windowBegin % windowSize] + _latency < _position)
+		{
+			++_windowBegin;
+		}
+
+		// The gain recovers exponentially, and is averaged over the look-ahead: every gain of the average is below
+		// the one required by the frame leaving the delay line, so the attack ends exactly on its peak
+
+		_releasedGain = std::min(_windowGains[_windowBegin % windowSize], 1.f - (1.f - _releasedGain) * _releaseFactor);
+
+		float& smoothedGain = _smoothedGains[_position % _latency];
+		_gainSum += _releasedGain - smoothedGain;
+		smoothedGain = _releasedGain;
+
+		++_position;
+
+		return _gainSum / _latency;
+	}
+}
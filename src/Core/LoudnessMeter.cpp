@@ -0,0 +1,390 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	namespace
+	{
+		constexpr float silence = -std::numeric_limits<float>::infinity();
+		constexpr double absoluteGate = -70.0;
+		constexpr double relativeGate = -10.0;
+		constexpr double binsPerUnit = 10.0;
+
+		float toLoudness(double energy)
+		{
+			return energy > 0.0 ? static_cast<float>(-0.691 + 10.0 * std::log10(energy)) : silence;
+		}
+
+		float toDecibels(double amplitude)
+		{
+			return amplitude > 0.0 ? static_cast<float>(20.0 * std::log10(amplitude)) : silence;
+		}
+
+		std::array<double, 5> computeBiquad(double b0, double b1, double b2, double a0, double a1, double a2)
+		{
+			return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+		}
+	}
+
+	LoudnessMeter::LoudnessMeter() :
+		_frequency(0),
+		_channelCount(0),
+		_subBlockFrameCount(0),
+
+		_channelWeights(),
+		_shelfCoefficients(),
+		_highPassCoefficients(),
+		_filterStates(),
+		_peakTaps(),
+
+		_channelSamples(),
+		_oversampledSamples(),
+
+		_subBlockPosition(0),
+		_subBlockEnergy(0.0),
+		_subBlockSquares(0.0),
+		_subBlockPeak(0.f),
+
+		_subBlockCount(0),
+		_energies(),
+		_squares(),
+		_peaks(),
+		_maxTruePeak(0.f),
+
+		_histogramCounts(),
+		_histogramEnergies(),
+
+		_resetRequested(false),
+		_sequence(0),
+		_statistics()
+	{
+		clear();
+	}
+
+	void LoudnessMeter::setFormat(uint32_t frequency, uint16_t channelCount)
+	{
+		assert(frequency != 0);
+		assert(channelCount != 0);
+
+		_frequency = frequency;
+		_channelCount = channelCount;
+		_subBlockFrameCount = (frequency + 5) / 10;
+
+		// Channels are weighted as in ITU-R BS.1770: surround channels count more, the low frequency one is ignored
+
+		_channelWeights.assign(channelCount, 1.f);
+
+		const Speaker* speakers;
+		if (ChannelMatrix::getStandardLayout(channelCount, speakers))
+		{
+			for (uint16_t i = 0; i < channelCount; ++i)
+			{
+				if (speakers[i] == Speaker::LowFrequency)
+				{
+					_channelWeights[i] = 0.f;
+				}
+				else if (speakers[i] != Speaker::FrontLeft && speakers[i] != Speaker::FrontRight && speakers[i] != Speaker::FrontCenter)
+				{
+					_channelWeights[i] = 1.41f;
+				}
+			}
+		}
+
+		// The K-weighting filter is a high shelf followed by a high pass, designed from their analog prototypes so
+		// that any frequency matches the coefficients the standard gives at 48kHz
+
+		{
+			const double k = std::tan(std::numbers::pi * 1681.974450955533 / frequency);
+			const double q = 0.7071752369554196;
+			const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+			const double vb = std::pow(vh, 0.4996667741545416);
+
+			_shelfCoefficients = computeBiquad(vh + vb * k / q + k * k, 2.0 * (k * k - vh), vh - vb * k / q + k * k, 1.0 + k / q + k * k, 2.0 * (k * k - 1.0), 1.0 - k / q + k * k);
+		}
+
+		{
+			const double k = std::tan(std::numbers::pi * 38.13547087602444 / frequency);
+			const double q = 0.5003270373238773;
+			const double a0 = 1.0 + k / q + k * k;
+
+			_highPassCoefficients = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+		}
+
+		// True peaks are searched in the signal oversampled 4 times, with a Hann windowed sinc interpolator
+
+		for (uint64_t p = 0; p < _phaseCount; ++p)
+		{
+			for (uint64_t k = 0; k < _tapCount; ++k)
+			{
+				const double t = static_cast<double>(k) - (_tapCount / 2 - 1) - static_cast<double>(p) / _phaseCount;
+				const double sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * t) / (std::numbers::pi * t);
+				const double window = 0.5 * (1.0 + std::cos(std::numbers::pi * t / (_tapCount / 2)));
+
+				_peakTaps[p * _tapCount + k] = static_cast<float>(sinc * window);
+			}
+		}
+
+		_filterStates.resize(4 * channelCount);
+		_channelSamples.resize((_tapCount - 1 + _chunkFrameCount) * channelCount);
+		_oversampledSamples.resize(_chunkFrameCount);
+		_histogramCounts.resize(_histogramBinCount);
+		_histogramEnergies.resize(_histogramBinCount);
+
+		clear();
+	}
+
+	void LoudnessMeter::process(const int32_t* samples, uint64_t frameCount)
+	{
+		processSamples(samples, frameCount);
+	}
+
+	void LoudnessMeter::process(const float* mix, uint64_t frameCount)
+	{
+		processSamples(mix, frameCount);
+	}
+
+	void LoudnessMeter::reset()
+	{
+		// The audio thread owns the state, it clears it at its next block
+
+		_resetRequested.store(true, std::memory_order_release);
+	}
+
+	LoudnessStatistics LoudnessMeter::getStatistics() const
+	{
+		// Sequence lock: the values are read again if the audio thread published while they were read
+
+		LoudnessStatistics statistics;
+
+		uint64_t sequence;
+		do
+		{
+			sequence = _sequence.load(std::memory_order_acquire);
+
+			statistics.truePeak = _statistics.truePeak.load(std::memory_order_relaxed);
+			statistics.maxTruePeak = _statistics.maxTruePeak.load(std::memory_order_relaxed);
+			statistics.rmsLevel = _statistics.rmsLevel.load(std::memory_order_relaxed);
+			statistics.momentaryLoudness = _statistics.momentaryLoudness.load(std::memory_order_relaxed);
+			statistics.shortTermLoudness = _statistics.shortTermLoudness.load(std::memory_order_relaxed);
+			statistics.integratedLoudness = _statistics.integratedLoudness.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		while ((sequence & 1) || sequence != _sequence.load(std::memory_order_relaxed));
+
+		return statistics;
+	}
+
+	template<typename TInput>
+	void LoudnessMeter::processSamples(const TInput* samples, uint64_t frameCount)
+	{
+		if (_channelCount == 0)
+		{
+			return;
+		}
+
+		if (_resetRequested.load(std::memory_order_relaxed) && _resetRequested.exchange(false, std::memory_order_acquire))
+		{
+			clear();
+		}
+
+		// Blocks are cut at the boundaries of the 100ms sub-blocks the loudness windows are made of
+
+		while (frameCount != 0)
+		{
+			const uint64_t chunkFrameCount = std::min({ frameCount, _chunkFrameCount, _subBlockFrameCount - _subBlockPosition });
+
+			for (uint16_t i = 0; i < _channelCount; ++i)
+			{
+				float* channelSamples = _channelSamples.data() + i * (_tapCount - 1 + _chunkFrameCount) + _tapCount - 1;
+				_crz::deinterleave(channelSamples, samples + i, chunkFrameCount, _channelCount, 1.f / 2147483648.f);
+
+				processChannel(i, chunkFrameCount);
+			}
+
+			samples += chunkFrameCount * _channelCount;
+			frameCount -= chunkFrameCount;
+			_subBlockPosition += chunkFrameCount;
+
+			if (_subBlockPosition == _subBlockFrameCount)
+			{
+				completeSubBlock();
+			}
+		}
+	}
+
+	void LoudnessMeter::processChannel(uint16_t channel, uint64_t frameCount)
+	{
+		float* history = _channelSamples.data() + channel * (_tapCount - 1 + _chunkFrameCount);
+		const float* samples = history + _tapCount - 1;
+
+		_subBlockSquares += _crz::sumSquares(samples, frameCount);
+
+		for (uint64_t i = 0; i < _phaseCount; ++i)
+		{
+			_crz::convolve(_oversampledSamples.data(), history, frameCount, _peakTaps.data() + i * _tapCount, _tapCount);
+			_subBlockPeak = std::max(_subBlockPeak, _crz::maxAbs(_oversampledSamples.data(), frameCount));
+		}
+
+		// The K-weighting filter is recursive, it runs sample by sample in double precision to stay stable at the low
+		// cutoff frequency of its high pass
+
+		if (_channelWeights[channel] != 0.f)
+		{
+			const std::array<double, 5>& shelf = _shelfCoefficients;
+			const std::array<double, 5>& highPass = _highPassCoefficients;
+			double* states = _filterStates.data() + 4 * channel;
+
+			double energy = 0.0;
+			for (uint64_t i = 0; i < frameCount; ++i)
+			{
+				const double x = samples[i];
+
+				const double y = shelf[0] * x + states[0];
+				states[0] = shelf[1] * x - shelf[3] * y + states[1];
+				states[1] = shelf[2] * x - shelf[4] * y;
+
+				const double z = highPass[0] * y + states[2];
+				states[2] = highPass[1] * y - highPass[3] * z + states[3];
+				states[3] = highPass[2] * y - highPass[4] * z;
+
+				energy += z * z;
+			}
+
+			_subBlockEnergy += _channelWeights[channel] * energy;
+		}
+
+		std::copy_n(history + frameCount, _tapCount - 1, history);
+	}
+
+	void LoudnessMeter::completeSubBlock()
+	{
+		const uint64_t index = _subBlockCount % _shortTermBlockCount;
+		_energies[index] = _subBlockEnergy;
+		_squares[index] = _subBlockSquares;
+		_peaks[index] = _subBlockPeak;
+		++_subBlockCount;
+
+		_maxTruePeak = std::max(_maxTruePeak, _subBlockPeak);
+
+		_subBlockPosition = 0;
+		_subBlockEnergy = 0.0;
+		_subBlockSquares = 0.0;
+		_subBlockPeak = 0.f;
+
+		// Momentary values are over the last 400ms, short-term ones over the last 3s. Windows are filled with
+		// silence until enough sub-blocks were measured.
+
+		double momentaryEnergy = 0.0;
+		double momentarySquares = 0.0;
+		float momentaryPeak = 0.f;
+		for (uint64_t i = 0; i < _momentaryBlockCount; ++i)
+		{
+			const uint64_t j = (_subBlockCount + _shortTermBlockCount - 1 - i) % _shortTermBlockCount;
+			momentaryEnergy += _energies[j];
+			momentarySquares += _squares[j];
+			momentaryPeak = std::max(momentaryPeak, _peaks[j]);
+		}
+
+		double shortTermEnergy = 0.0;
+		for (uint64_t i = 0; i < _shortTermBlockCount; ++i)
+		{
+			shortTermEnergy += _energies[i];
+		}
+
+		momentaryEnergy /= _momentaryBlockCount * _subBlockFrameCount;
+		momentarySquares /= _momentaryBlockCount * _subBlockFrameCount * _channelCount;
+		shortTermEnergy /= _shortTermBlockCount * _subBlockFrameCount;
+
+		// The integrated loudness is gated over all 400ms blocks, overlapping by 75%. Blocks are kept in a histogram
+		// of 0.1 LU bins, so the relative gate is applied with that precision whatever the length of the measure.
+
+		const float momentaryLoudness = toLoudness(momentaryEnergy);
+		if (_subBlockCount >= _momentaryBlockCount && momentaryLoudness > absoluteGate)
+		{
+			const uint64_t bin = std::min(static_cast<uint64_t>((momentaryLoudness - absoluteGate) * binsPerUnit), _histogramBinCount - 1);
+			++_histogramCounts[bin];
+			_histogramEnergies[bin] += momentaryEnergy;
+		}
+
+		uint64_t gatedCount = 0;
+		double gatedEnergy = 0.0;
+		for (uint64_t i = 0; i < _histogramBinCount; ++i)
+		{
+			gatedCount += _histogramCounts[i];
+			gatedEnergy += _histogramEnergies[i];
+		}
+
+		float integratedLoudness = silence;
+		if (gatedCount != 0)
+		{
+			const double threshold = toLoudness(gatedEnergy / gatedCount) + relativeGate;
+			const uint64_t firstBin = static_cast<uint64_t>(std::clamp((threshold - absoluteGate) * binsPerUnit, 0.0, _histogramBinCount - 1.0));
+
+			gatedCount = 0;
+			gatedEnergy = 0.0;
+			for (uint64_t i = firstBin; i < _histogramBinCount; ++i)
+			{
+				gatedCount += _histogramCounts[i];
+				gatedEnergy += _histogramEnergies[i];
+			}
+
+			integratedLoudness = gatedCount == 0 ? silence : toLoudness(gatedEnergy / gatedCount);
+		}
+
+		LoudnessStatistics statistics;
+		statistics.truePeak = toDecibels(momentaryPeak);
+		statistics.maxTruePeak = toDecibels(_maxTruePeak);
+		statistics.rmsLevel = toDecibels(std::sqrt(momentarySquares));
+		statistics.momentaryLoudness = momentaryLoudness;
+		statistics.shortTermLoudness = toLoudness(shortTermEnergy);
+		statistics.integratedLoudness = integratedLoudness;
+
+		publish(statistics);
+	}
+
+	void LoudnessMeter::clear()
+	{
+		std::fill(_filterStates.begin(), _filterStates.end(), 0.0);
+		std::fill(_channelSamples.begin(), _channelSamples.end(), 0.f);
+
+		_subBlockPosition = 0;
+		_subBlockEnergy = 0.0;
+		_subBlockSquares = 0.0;
+		_subBlockPeak = 0.f;
+
+		_subBlockCount = 0;
+		_energies.fill(0.0);
+		_squares.fill(0.0);
+		_peaks.fill(0.f);
+		_maxTruePeak = 0.f;
+
+		std::fill(_histogramCounts.begin(), _histogramCounts.end(), 0);
+		std::fill(_histogramEnergies.begin(), _histogramEnergies.end(), 0.0);
+
+		publish({ silence, silence, silence, silence, silence, silence });
+	}
+
+	void LoudnessMeter::publish(const LoudnessStatistics& statistics)
+	{
+		const uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+		_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		_statistics.truePeak.store(statistics.truePeak, std::memory_order_relaxed);
+		_statistics.maxTruePeak.store(statistics.maxTruePeak, std::memory_order_relaxed);
+		_statistics.rmsLevel.store(statistics.rmsLevel, std::memory_order_relaxed);
+		_statistics.momentaryLoudness.store(statistics.momentaryLoudness, std::memory_order_relaxed);
+		_statistics.shortTermLoudness.store(statistics.shortTermLoudness, std::memory_order_relaxed);
+		_statistics.integratedLoudness.store(statistics.integratedLoudness, std::memory_order_relaxed);
+
+		_sequence.store(sequence + 2, std::memory_order_release);
+	}
+}
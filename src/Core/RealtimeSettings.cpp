@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+	#include <sys/mman.h>
+	#include <sys/resource.h>
+#endif
+
+namespace crz
+{
+	namespace
+	{
+		constexpr uint64_t stackPageSize = 4096;
+		constexpr uint64_t stackGuardSize = 16 * stackPageSize;
+
+		// Each call touches one page of the stack, the page is used again after the recursive call so that the call
+		// cannot be turned into a jump reusing the same frame
+
+		uint64_t prefaultStack(uint64_t size)
+		{
+			volatile uint8_t page[stackPageSize];
+			page[0] = 0;
+			page[stackPageSize - 1] = 0;
+
+			const uint64_t prefaultedSize = size > stackPageSize ? prefaultStack(size - stackPageSize) : 0;
+
+			return prefaultedSize + stackPageSize + page[0];
+		}
+
+		// The stack left below the current frame, minus a margin for the frames of prefaultStack itself and for what
+		// the thread calls afterwards. Without a way to know it, nothing is prefaulted.
+
+		uint64_t getAvailableStackSize()
+		{
+			volatile uint8_t stackTop = 0;
+			const uint8_t* stackPointer = const_cast<const uint8_t*>(&stackTop);
+			uint64_t availableSize = 0;
+
+			#if defined(__linux__)
+				pthread_attr_t attributes;
+				if (pthread_getattr_np(pthread_self(), &attributes) == 0)
+				{
+					void* stackAddress;
+					size_t stackSize;
+					if (pthread_attr_getstack(&attributes, &stackAddress, &stackSize) == 0 && stackPointer > stackAddress)
+					{
+						availableSize = stackPointer - reinterpret_cast<const uint8_t*>(stackAddress);
+					}
+
+					pthread_attr_destroy(&attributes);
+				}
+			#elif defined(_WIN32)
+				ULONG_PTR lowLimit, highLimit;
+				GetCurrentThreadStackLimits(&lowLimit, &highLimit);
+				if (reinterpret_cast<ULONG_PTR>(stackPointer) > lowLimit)
+				{
+					availableSize = reinterpret_cast<ULONG_PTR>(stackPointer) - lowLimit;
+				}
+			#endif
+
+			const uint64_t marginSize = stackGuardSize + availableSize / 16;
+			return availableSize > marginSize ? availableSize - marginSize : 0;
+		}
+
+		#if defined(__linux__)
+			ThreadPolicy getThreadPolicy(int policy)
+			{
+				switch (policy)
+				{
+					case SCHED_FIFO:
+						return ThreadPolicy::Fifo;
+					case SCHED_RR:
+						return ThreadPolicy::RoundRobin;
+					default:
+						return ThreadPolicy::Default;
+				}
+			}
+		#endif
+	}
+
+	RealtimeReport RealtimeSettings::applyToCurrentThread() const
+	{
+		RealtimeReport report;
+		report.policy = ThreadPolicy::Default;
+		report.priority = 0;
+		report.cpus = {};
+		report.memoryLocked = false;
+		report.prefaultedStackSize = 0;
+
+		#if defined(__linux__)
+			// Unprivileged processes may still be allowed realtime priorities up to RLIMIT_RTPRIO: the priority asked is
+			// lowered to that limit before giving up and keeping the default policy
+
+			if (policy != ThreadPolicy::Default)
+			{
+				const int nativePolicy = policy == ThreadPolicy::Fifo ? SCHED_FIFO : SCHED_RR;
+
+				sched_param parameters = {};
+				parameters.sched_priority = std::clamp<int>(priority, sched_get_priority_min(nativePolicy), sched_get_priority_max(nativePolicy));
+
+				if (pthread_setschedparam(pthread_self(), nativePolicy, &parameters) != 0)
+				{
+					rlimit limit;
+					if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur != 0 && limit.rlim_cur < static_cast<rlim_t>(parameters.sched_priority))
+					{
+						parameters.sched_priority = limit.rlim_cur;
+						pthread_setschedparam(pthread_self(), nativePolicy, &parameters);
+					}
+				}
+			}
+
+			// What is reported is read back from the thread, not what was asked
+
+			int nativePolicy;
+			sched_param parameters;
+			if (pthread_getschedparam(pthread_self(), &nativePolicy, &parameters) == 0)
+			{
+				report.policy = getThreadPolicy(nativePolicy);
+				report.priority = parameters.sched_priority;
+			}
+
+			if (!cpus.empty())
+			{
+				cpu_set_t cpuSet;
+				CPU_ZERO(&cpuSet);
+				for (uint16_t cpu : cpus)
+				{
+					if (cpu < CPU_SETSIZE)
+					{
+						CPU_SET(cpu, &cpuSet);
+					}
+				}
+
+				if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0 && pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0)
+				{
+					for (uint16_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+					{
+						if (CPU_ISSET(cpu, &cpuSet))
+						{
+							report.cpus.push_back(cpu);
+						}
+					}
+				}
+			}
+
+			// Locking is for the whole process: the pages mapped now are faulted in, and so will be the ones mapped later
+
+			if (lockMemory)
+			{
+				report.memoryLocked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+			}
+		#elif defined(_WIN32)
+			// Windows has no realtime policies outside of the realtime priority class, both are mapped to the highest
+			// priority of the class of the process. Memory cannot be locked for the whole process.
+
+			if (policy != ThreadPolicy::Default && SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+			{
+				report.policy = policy;
+				report.priority = THREAD_PRIORITY_TIME_CRITICAL;
+			}
+
+			if (!cpus.empty())
+			{
+				DWORD_PTR mask = 0;
+				for (uint16_t cpu : cpus)
+				{
+					if (cpu < 8 * sizeof(DWORD_PTR))
+					{
+						mask |= DWORD_PTR(1) << cpu;
+					}
+				}
+
+				if (mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0)
+				{
+					for (uint16_t cpu = 0; cpu < 8 * sizeof(DWORD_PTR); ++cpu)
+					{
+						if (mask & (DWORD_PTR(1) << cpu))
+						{
+							report.cpus.push_back(cpu);
+						}
+					}
+				}
+			}
+		#endif
+
+		// The stack is prefaulted last, so that its pages are locked as well when memory is, and never beyond its end
+
+		const uint64_t stackSize = std::min(prefaultedStackSize, getAvailableStackSize());
+		if (stackSize != 0)
+		{
+			report.prefaultedStackSize = prefaultStack(stackSize);
+		}
+
+		return report;
+	}
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	SampleConverter::SampleConverter(SampleFormat format, Dithering dithering) :
+		_format(format),
+		_dithering(dithering),
+		_ditherPosition(0)
+	{
+	}
+
+	uint64_t SampleConverter::getSampleSize(SampleFormat format)
+	{
+		switch (format)
+		{
+			case SampleFormat::Int16:
+				return 2;
+			case SampleFormat::Int24:
+				return 3;
+			default:
+				return 4;
+		}
+	}
+
+	SampleFormat SampleConverter::getFormat() const
+	{
+		return _format;
+	}
+
+	uint64_t SampleConverter::getSampleSize() const
+	{
+		return getSampleSize(_format);
+	}
+
+	void SampleConverter::setDithering(Dithering dithering)
+	{
+		_dithering = dithering;
+	}
+
+	Dithering SampleConverter::getDithering() const
+	{
+		return _dithering;
+	}
+
+	void SampleConverter::decode(int32_t* samples, const void* input, uint64_t sampleCount) const
+	{
+		switch (_format)
+		{
+			case SampleFormat::Int16:
+				_crz::decodeInt16(samples, reinterpret_cast<const int16_t*>(input), sampleCount);
+				break;
+			case SampleFormat::Int24:
+				_crz::decodeInt24(samples, reinterpret_cast<const uint8_t*>(input), sampleCount);
+				break;
+			case SampleFormat::Int32:
+				std::copy_n(reinterpret_cast<const int32_t*>(input), sampleCount, samples);
+				break;
+			case SampleFormat::Float32:
+				_crz::decodeFloat32(samples, reinterpret_cast<const float*>(input), sampleCount);
+				break;
+		}
+	}
+
+	void SampleConverter::encode(void* output, const int32_t* samples, uint64_t sampleCount)
+	{
+		encodeSamples(output, samples, sampleCount);
+	}
+
+	void SampleConverter::encode(void* output, const float* mix, uint64_t sampleCount)
+	{
+		encodeSamples(output, mix, sampleCount);
+	}
+
+	template<typename TInput>
+	void SampleConverter::encodeSamples(void* output, const TInput* input, uint64_t sampleCount)
+	{
+		// The dither noise continues from one call to the next, it only repeats every 2^32 samples
+
+		const bool dither = _dithering == Dithering::Triangular;
+
+		switch (_format)
+		{
+			case SampleFormat::Int16:
+				if (dither)
+				{
+					_crz::encodeInt16<true>(reinterpret_cast<int16_t*>(output), input, sampleCount, _ditherPosition);
+				}
+				else
+				{
+					_crz::encodeInt16<false>(reinterpret_cast<int16_t*>(output), input, sampleCount, _ditherPosition);
+				}
+				break;
+			case SampleFormat::Int24:
+				if (dither)
+				{
+					_crz::encodeInt24<true>(reinterpret_cast<uint8_t*>(output), input, sampleCount, _ditherPosition);
+				}
+				else
+				{
+					_crz::encodeInt24<false>(reinterpret_cast<uint8_t*>(output), input, sampleCount, _ditherPosition);
+				}
+				break;
+			case SampleFormat::Int32:
+				_crz::encodeInt32(reinterpret_cast<int32_t*>(output), input, sampleCount);
+				break;
+			case SampleFormat::Float32:
+				_crz::encodeFloat32(reinterpret_cast<float*>(output), input, sampleCount);
+				break;
+		}
+
+		_ditherPosition += static_cast<uint32_t>(sampleCount);
+	}
+}
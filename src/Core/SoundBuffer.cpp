@@ -11,6 +11,7 @@
 namespace crz
 {
 	SoundBuffer::SoundBuffer(uint32_t frequency, uint16_t channelCount, uint64_t sampleCount, const int32_t* samples) : SoundBase(),
+		_ownedSamples(),
 		_samples(samples)
 	{
 		assert(frequency != 0);
@@ -21,6 +22,41 @@ namespace crz
 		_sampleCount = sampleCount;
 	}
 
+	SoundBuffer::SoundBuffer(SoundSource& source, uint32_t frequency, uint16_t channelCount) : SoundBase(),
+		_ownedSamples(),
+		_samples(nullptr)
+	{
+		assert(frequency != 0);
+		assert(channelCount != 0);
+
+		_frequency = frequency;
+		_channelCount = channelCount;
+
+		// The source is converted once, here, so that playing at this frequency and channel count is a plain copy. It
+		// is read from its current sample to its end, in contiguous chunks.
+
+		// A source without frequency or channels, like a file that failed to open, gives an empty buffer
+
+		const uint32_t sourceFrequency = source.getFrequency();
+		if (sourceFrequency == 0 || source.getChannelCount() == 0)
+		{
+			return;
+		}
+
+		const uint64_t timeFrom = (source.getCurrentSample() * frequency + sourceFrequency - 1) / sourceFrequency;
+		const uint64_t timeTo = (source.getSampleCount() * frequency + sourceFrequency - 1) / sourceFrequency;
+
+		_sampleCount = timeTo > timeFrom ? timeTo - timeFrom : 0;
+		_ownedSamples.resize(_sampleCount * _channelCount);
+		_samples = _ownedSamples.data();
+
+		for (uint64_t time = timeFrom; time < timeTo; time += _conversionFrameCount)
+		{
+			const uint64_t chunkEnd = std::min(time + _conversionFrameCount, timeTo);
+			source.getSamples(_frequency, _channelCount, _ownedSamples.data() + (time - timeFrom) * _channelCount, time, chunkEnd);
+		}
+	}
+
 	void SoundBuffer::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
 	{
 		std::copy_n(_samples + timeFrom * _channelCount, (timeTo - timeFrom) * _channelCount, samples);
@@ -12,22 +12,42 @@ namespace crz
 {
 	namespace
 	{
-		inline uint64_t crzRead(void* handle, uint8_t* data, uint64_t size)
+		uint64_t readLittleEndian(const uint8_t* data, uint8_t byteCount)
 		{
-			return std::fread(data, 1, size, reinterpret_cast<std::FILE*>(handle));
+			uint64_t value = 0;
+			for (uint8_t i = 0; i < byteCount; ++i)
+			{
+				value |= uint64_t(data[i]) << (8 * i);
+			}
+
+			return value;
 		}
 
-		inline bool crzEof(void* handle)
+		bool seekFile(std::FILE* file, uint64_t offset)
 		{
-			return std::feof(reinterpret_cast<std::FILE*>(handle));
+			#if defined(_WIN32)
+				return _fseeki64(file, offset, SEEK_SET) == 0;
+			#else
+				return fseeko(file, offset, SEEK_SET) == 0;
+			#endif
+		}
+
+		void swapBytes(uint8_t* data, uint64_t sampleCount, uint64_t sampleSize)
+		{
+			for (uint64_t i = 0; i < sampleCount; ++i, data += sampleSize)
+			{
+				std::reverse(data, data + sampleSize);
+			}
 		}
 	}
 
 	SoundFile::SoundFile(const std::filesystem::path& path, SoundFileFormat format) : SoundBase(),
 		_format(format),
 		_file(nullptr),
-		_stream(nullptr),
-		_formatStream(nullptr)
+		_converter(),
+		_dataOffset(0),
+		_frameSize(0),
+		_fileSamples()
 	{
 		if (!std::filesystem::exists(path))
 		{
@@ -40,59 +60,197 @@ namespace crz
 			return;
 		}
 
-		_stream = new dsk::IStream(_file, crzRead, crzEof);
-
+		bool success = false;
 		switch (_format)
 		{
 			case SoundFileFormat::Wave:
+				success = readWaveHeader();
+				break;
+		}
+
+		if (!success)
+		{
+			std::fclose(_file);
+			_file = nullptr;
+			return;
+		}
+
+		_frameSize = _converter.getSampleSize() * _channelCount;
+		_fileSamples.resize(_maxChunkFrameCount * _frameSize);
+	}
+
+	SampleFormat SoundFile::getSampleFormat() const
+	{
+		return _converter.getFormat();
+	}
+
+	bool SoundFile::isValid() const
+	{
+		return _file;
+	}
+
+	SoundFile::~SoundFile()
+	{
+		if (_file)
+		{
+			std::fclose(_file);
+		}
+	}
+
+	bool SoundFile::readWaveHeader()
+	{
+		uint8_t header[12];
+		if (std::fread(header, 1, 12, _file) != 12 || !std::equal(header + 8, header + 12, "WAVE"))
+		{
+			return false;
+		}
+
+		const bool rf64 = std::equal(header, header + 4, "RF64");
+		if (!rf64 && !std::equal(header, header + 4, "RIFF"))
+		{
+			return false;
+		}
+
+		// Walk the chunks until the samples, an RF64 file gives the sizes that do not fit on 32 bits in its ds64 chunk
+
+		uint64_t position = 12;
+		uint64_t ds64DataSize = 0;
+		bool hasFormat = false;
+
+		while (true)
+		{
+			uint8_t chunkHeader[8];
+			if (!seekFile(_file, position) || std::fread(chunkHeader, 1, 8, _file) != 8)
 			{
-				dsk::fmt::WaveIStream* waveIStream = new dsk::fmt::WaveIStream(_stream);
-				
-				dsk::fmt::wave::Header header;
-				waveIStream->readHeader(header);
+				return false;
+			}
 
-				_frequency = header.metadata.frequency;
-				_channelCount = header.metadata.channelCount;
-				_sampleCount = header.blockCount;
+			uint64_t chunkSize = readLittleEndian(chunkHeader + 4, 4);
 
-				_formatStream = waveIStream;
+			if (std::equal(chunkHeader, chunkHeader + 4, "ds64"))
+			{
+				uint8_t ds64[16];
+				if (chunkSize < 16 || std::fread(ds64, 1, 16, _file) != 16)
+				{
+					return false;
+				}
 
-				break;
+				ds64DataSize = readLittleEndian(ds64 + 8, 8);
 			}
+			else if (std::equal(chunkHeader, chunkHeader + 4, "fmt "))
+			{
+				uint8_t fmt[26] = {};
+				if (chunkSize < 16 || std::fread(fmt, 1, std::min<uint64_t>(chunkSize, 26), _file) < 16)
+				{
+					return false;
+				}
+
+				// Extensible formats give the actual format tag at the start of their sub-format GUID
+
+				uint16_t formatTag = readLittleEndian(fmt, 2);
+				if (formatTag == 0xFFFE && chunkSize >= 26)
+				{
+					formatTag = readLittleEndian(fmt + 24, 2);
+				}
+
+				_channelCount = readLittleEndian(fmt + 2, 2);
+				_frequency = readLittleEndian(fmt + 4, 4);
+				const uint16_t bitsPerSample = readLittleEndian(fmt + 14, 2);
+				const uint16_t blockAlign = readLittleEndian(fmt + 12, 2);
+
+				if (formatTag == 1 && bitsPerSample == 16)
+				{
+					_converter = SampleConverter(SampleFormat::Int16);
+				}
+				else if (formatTag == 1 && bitsPerSample == 24)
+				{
+					_converter = SampleConverter(SampleFormat::Int24);
+				}
+				else if (formatTag == 1 && bitsPerSample == 32)
+				{
+					_converter = SampleConverter(SampleFormat::Int32);
+				}
+				else if (formatTag == 3 && bitsPerSample == 32)
+				{
+					_converter = SampleConverter(SampleFormat::Float32);
+				}
+				else
+				{
+					return false;
+				}
+
+				if (_channelCount == 0 || _frequency == 0 || blockAlign != _converter.getSampleSize() * _channelCount)
+				{
+					return false;
+				}
+
+				hasFormat = true;
+			}
+			else if (std::equal(chunkHeader, chunkHeader + 4, "data"))
+			{
+				if (!hasFormat)
+				{
+					return false;
+				}
+
+				if (rf64 && chunkSize == UINT32_MAX)
+				{
+					chunkSize = ds64DataSize;
+				}
+
+				_dataOffset = position + 8;
+				_sampleCount = chunkSize / (_converter.getSampleSize() * _channelCount);
+				_currentSample = 0;
+
+				return true;
+			}
+
+			position += 8 + chunkSize + (chunkSize & 1);
 		}
 	}
 
 	void SoundFile::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
 	{
-		if (!_stream->getStatus())
+		const TraceSpan span("SoundFile::getRawSamples", timeFrom);
+
+		if (!_file)
 		{
 			std::fill_n(samples, (timeTo - timeFrom) * _channelCount, 0);
 			return;
 		}
 
-		switch (_format)
+		// The file position follows the current sample, it is only moved when the sound jumps
+
+		if (timeFrom != _currentSample && !seekFile(_file, _dataOffset + timeFrom * _frameSize))
 		{
-			case SoundFileFormat::Wave:
+			std::fill_n(samples, (timeTo - timeFrom) * _channelCount, 0);
+			return;
+		}
+
+		uint64_t time = timeFrom;
+		while (time < timeTo)
+		{
+			const uint64_t frameCount = std::min(timeTo - time, _maxChunkFrameCount);
+			const uint64_t readFrameCount = std::fread(_fileSamples.data(), _frameSize, frameCount, _file);
+
+			if constexpr (std::endian::native == std::endian::big)
 			{
-				dsk::fmt::WaveIStream* waveIStream = dynamic_cast<dsk::fmt::WaveIStream*>(_formatStream);
+				swapBytes(_fileSamples.data(), readFrameCount * _channelCount, _converter.getSampleSize());
+			}
 
-				if (timeFrom != _currentSample)
-				{
-					waveIStream->skipBlocks(timeFrom - _currentSample);
-				}
+			_converter.decode(samples, _fileSamples.data(), readFrameCount * _channelCount);
+			samples += readFrameCount * _channelCount;
+			time += readFrameCount;
 
-				waveIStream->readSampleBlocks(samples, timeTo - timeFrom);
+			// A truncated file ends with silence
+
+			if (readFrameCount != frameCount)
+			{
+				std::fill_n(samples, (timeTo - time) * _channelCount, 0);
 				break;
 			}
 		}
 
 		_currentSample = timeTo;
 	}
-
-	SoundFile::~SoundFile()
-	{
-		delete _formatStream;
-		delete _stream;
-		std::fclose(_file);
-	}
 }
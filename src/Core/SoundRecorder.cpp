@@ -0,0 +1,432 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+#if defined(__linux__)
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace crz
+{
+	namespace
+	{
+		constexpr uint64_t recordAlignment = 4096;
+
+		// Direct I/O and preallocation are only available on Linux, other platforms write through the C library
+
+		class RecordFile
+		{
+			public:
+
+				bool open(const std::filesystem::path& path, bool directIo, uint64_t preallocatedSize)
+				{
+					#if defined(__linux__)
+						_descriptor = -1;
+						if (directIo)
+						{
+							_descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+							_directIo = _descriptor >= 0;
+						}
+
+						if (_descriptor < 0)
+						{
+							_descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+						}
+
+						if (_descriptor >= 0 && preallocatedSize != 0)
+						{
+							posix_fallocate(_descriptor, 0, preallocatedSize);
+						}
+
+						return _descriptor >= 0;
+					#else
+						_file = std::fopen(path.string().c_str(), "wb");
+						_position = 0;
+
+						return _file;
+					#endif
+				}
+
+				bool write(uint64_t offset, const uint8_t* data, uint64_t size)
+				{
+					#if defined(__linux__)
+						// Unaligned writes (the header and the last chunk) cannot go through direct I/O
+
+						if (_directIo && (offset % recordAlignment != 0 || size % recordAlignment != 0))
+						{
+							fcntl(_descriptor, F_SETFL, fcntl(_descriptor, F_GETFL) & ~O_DIRECT);
+							_directIo = false;
+						}
+
+						while (size != 0)
+						{
+							const ssize_t written = pwrite(_descriptor, data, size, offset);
+							if (written <= 0)
+							{
+								return false;
+							}
+
+							data += written;
+							offset += written;
+							size -= written;
+						}
+
+						return true;
+					#else
+						if (offset != _position)
+						{
+							assert(offset == 0);
+
+							std::fflush(_file);
+							std::rewind(_file);
+						}
+
+						_position = offset + size;
+
+						return std::fwrite(data, 1, size, _file) == size;
+					#endif
+				}
+
+				void close(uint64_t size)
+				{
+					#if defined(__linux__)
+						// Remove what was preallocated but not written
+
+						ftruncate(_descriptor, size);
+						::close(_descriptor);
+					#else
+						std::fclose(_file);
+					#endif
+				}
+
+			private:
+
+				#if defined(__linux__)
+					int _descriptor = -1;
+					bool _directIo = false;
+				#else
+					std::FILE* _file = nullptr;
+					uint64_t _position = 0;
+				#endif
+		};
+
+		void writeLittleEndian(uint8_t* data, uint64_t value, uint8_t byteCount)
+		{
+			for (uint8_t i = 0; i < byteCount; ++i)
+			{
+				data[i] = value >> (8 * i);
+			}
+		}
+	}
+
+	SoundRecorder::SoundRecorder(AudioInput& input, const std::filesystem::path& path, SampleFormat format, bool directIo, uint64_t preallocatedSize) :
+		_input(nullptr),
+		_activitySource(&input),
+		_reader(input.getRing()),
+		_file(nullptr),
+
+		_frequency(input.getFrequency()),
+		_channelCount(input.getChannelCount()),
+		_format(format),
+		_converter(format),
+		_frameSize(_converter.getSampleSize() * _channelCount),
+
+		_recordedFrameCount(0),
+		_droppedFrameCount(0),
+		_silentFrameCount(0),
+		_silenceSkipping(false),
+
+		_chunkFrameCount(std::clamp<uint64_t>(std::bit_floor(input.getRing().getReadableFrameCount() / 2), 4096, _maxChunkFrameCount)),
+		_chunk(nullptr),
+		_dataSize(0),
+
+		_stopPosition(UINT64_MAX),
+		_failed(false),
+		_writingThread(),
+
+		_realtimeSettings(),
+		_realtimeReport(),
+		_realtimeMutex(),
+		_realtimeCondition(),
+		_realtimeRequested(false),
+		_writing(false)
+	{
+		assert(input.isValid());
+
+		// Chunks hold a multiple of 4096 frames, their size is thus aligned whatever the sample format, and they are
+		// at most half of what the ring keeps so that the input can fill the other half while one is written
+
+		_chunk = reinterpret_cast<uint8_t*>(::operator new(_chunkFrameCount * _frameSize, std::align_val_t(recordAlignment)));
+
+		RecordFile* file = new RecordFile();
+		if (!file->open(path, directIo, preallocatedSize ? _headerSize + preallocatedSize : 0))
+		{
+			delete file;
+			return;
+		}
+
+		_file = file;
+
+		if (!writeHeader())
+		{
+			_failed = true;
+		}
+
+		_input = &input;
+		_writing = true;
+		_writingThread = std::thread(&SoundRecorder::writingLoop, this);
+	}
+
+	void SoundRecorder::stop()
+	{
+		if (!_input)
+		{
+			return;
+		}
+
+		// Everything captured until now is written, then the writing thread stops
+
+		_stopPosition.store(_input->getRing().getWritePosition(), std::memory_order_release);
+		_input = nullptr;
+
+		_writingThread.join();
+
+		if (!writeHeader())
+		{
+			_failed = true;
+		}
+
+		const uint64_t fileSize = _headerSize + _dataSize + (_dataSize & 1);
+		reinterpret_cast<RecordFile*>(_file)->close(fileSize);
+	}
+
+	void SoundRecorder::setSilenceSkipping(bool enabled)
+	{
+		_silenceSkipping.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool SoundRecorder::isSkippingSilence() const
+	{
+		return _silenceSkipping.load(std::memory_order_relaxed);
+	}
+
+	uint32_t SoundRecorder::getFrequency() const
+	{
+		return _frequency;
+	}
+
+	uint16_t SoundRecorder::getChannelCount() const
+	{
+		return _channelCount;
+	}
+
+	SampleFormat SoundRecorder::getSampleFormat() const
+	{
+		return _format;
+	}
+
+	uint64_t SoundRecorder::getRecordedFrameCount() const
+	{
+		return _recordedFrameCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t SoundRecorder::getDroppedFrameCount() const
+	{
+		return _droppedFrameCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t SoundRecorder::getSilentFrameCount() const
+	{
+		return _silentFrameCount.load(std::memory_order_relaxed);
+	}
+
+	bool SoundRecorder::isRecording() const
+	{
+		return _input;
+	}
+
+	bool SoundRecorder::isValid() const
+	{
+		return _file && !_failed;
+	}
+
+	RealtimeReport SoundRecorder::setRealtimeSettings(const RealtimeSettings& settings)
+	{
+		assert(isRecording());
+
+		// The writing thread applies the settings to itself, at most after one period of sleep, unless it already
+		// exited after reaching the stop position
+
+		std::unique_lock lock(_realtimeMutex);
+
+		_realtimeSettings = settings;
+		_realtimeRequested.store(true);
+		_realtimeCondition.wait(lock, [&] { return !_realtimeRequested.load() || !_writing; });
+
+		if (_realtimeRequested.load())
+		{
+			_realtimeRequested.store(false);
+			return RealtimeReport{ ThreadPolicy::Default, 0, {}, false, 0 };
+		}
+
+		return _realtimeReport;
+	}
+
+	SoundRecorder::~SoundRecorder()
+	{
+		stop();
+
+		delete reinterpret_cast<RecordFile*>(_file);
+		::operator delete(_chunk, std::align_val_t(recordAlignment));
+	}
+
+	void SoundRecorder::writingLoop()
+	{
+		RecordFile* file = reinterpret_cast<RecordFile*>(_file);
+		const std::chrono::duration<double> period(0.25 * _chunkFrameCount / _frequency);
+
+		uint64_t chunkFrameCount = 0;
+		uint64_t tornFrameCount = 0;
+
+		while (true)
+		{
+			if (_realtimeRequested.load())
+			{
+				std::lock_guard lock(_realtimeMutex);
+
+				_realtimeReport = _realtimeSettings.applyToCurrentThread();
+				_realtimeRequested.store(false);
+				_realtimeCondition.notify_all();
+			}
+
+			// Read the ring directly in the chunk, frames skipped or overwritten because the thread was late are lost
+
+			const uint64_t stopPosition = _stopPosition.load(std::memory_order_acquire);
+			const uint64_t maxFrameCount = std::min(_chunkFrameCount - chunkFrameCount, stopPosition - std::min(stopPosition, _reader.getPosition()));
+
+			const BroadcastView view = _reader.acquire(maxFrameCount);
+			const uint64_t frameCount = view.getFrameCount();
+
+			// When skipping silence, what the input gate closed on is left out of the file
+
+			const bool silent = frameCount != 0 && _silenceSkipping.load(std::memory_order_relaxed) && _activitySource->isSilent(view.position, view.position + frameCount);
+			if (!silent)
+			{
+				uint8_t* it = _chunk + chunkFrameCount * _frameSize;
+				for (uint8_t i = 0; i < 2; ++i)
+				{
+					_converter.encode(it, view.samples[i], view.frameCounts[i] * _channelCount);
+					it += view.frameCounts[i] * _frameSize;
+				}
+			}
+
+			// Frames overwritten while they were encoded are torn, they are left out of the file like skipped ones
+
+			if (!_reader.release(view))
+			{
+				tornFrameCount += frameCount;
+			}
+			else if (silent)
+			{
+				_silentFrameCount.fetch_add(frameCount, std::memory_order_relaxed);
+			}
+			else
+			{
+				chunkFrameCount += frameCount;
+				_recordedFrameCount.fetch_add(frameCount, std::memory_order_relaxed);
+			}
+			_droppedFrameCount.store(_reader.getSkippedFrameCount() + tornFrameCount, std::memory_order_relaxed);
+
+			// Write full chunks only, except for what remains when stopping
+
+			const bool stopped = _reader.getPosition() >= stopPosition;
+			if (chunkFrameCount == _chunkFrameCount || (stopped && chunkFrameCount != 0))
+			{
+				if (!_failed && !file->write(_headerSize + _dataSize, _chunk, chunkFrameCount * _frameSize))
+				{
+					_failed = true;
+				}
+
+				_dataSize += chunkFrameCount * _frameSize;
+				chunkFrameCount = 0;
+			}
+
+			if (stopped)
+			{
+				break;
+			}
+			else if (frameCount < maxFrameCount)
+			{
+				std::this_thread::sleep_for(period);
+			}
+		}
+
+		// RIFF chunks have an even size
+
+		if (!_failed && (_dataSize & 1))
+		{
+			const uint8_t padding = 0;
+			_failed = !file->write(_headerSize + _dataSize, &padding, 1);
+		}
+
+		std::lock_guard lock(_realtimeMutex);
+		_writing = false;
+		_realtimeCondition.notify_all();
+	}
+
+	bool SoundRecorder::writeHeader()
+	{
+		// The header fills the first 4096 bytes so that samples start aligned for direct I/O. A ds64 chunk is reserved
+		// and used instead of a JUNK chunk if the file grows beyond the 4 GiB a WAVE file can describe (RF64).
+
+		std::fill_n(_chunk, _headerSize, 0);
+
+		const uint64_t riffSize = _headerSize - 8 + _dataSize + (_dataSize & 1);
+		const bool rf64 = riffSize > UINT32_MAX;
+		const uint16_t containerBits = _converter.getSampleSize() * 8;
+
+		std::copy_n(rf64 ? "RF64" : "RIFF", 4, _chunk);
+		writeLittleEndian(_chunk + 4, rf64 ? UINT32_MAX : riffSize, 4);
+		std::copy_n("WAVE", 4, _chunk + 8);
+
+		std::copy_n(rf64 ? "ds64" : "JUNK", 4, _chunk + 12);
+		writeLittleEndian(_chunk + 16, 28, 4);
+		if (rf64)
+		{
+			writeLittleEndian(_chunk + 20, riffSize, 8);
+			writeLittleEndian(_chunk + 28, _dataSize, 8);
+			writeLittleEndian(_chunk + 36, _dataSize / _frameSize, 8);
+		}
+
+		std::copy_n("fmt ", 4, _chunk + 48);
+		writeLittleEndian(_chunk + 52, 40, 4);
+		writeLittleEndian(_chunk + 56, 0xFFFE, 2);
+		writeLittleEndian(_chunk + 58, _channelCount, 2);
+		writeLittleEndian(_chunk + 60, _frequency, 4);
+		writeLittleEndian(_chunk + 64, _frequency * _frameSize, 4);
+		writeLittleEndian(_chunk + 68, _frameSize, 2);
+		writeLittleEndian(_chunk + 70, containerBits, 2);
+		writeLittleEndian(_chunk + 72, 22, 2);
+		writeLittleEndian(_chunk + 74, containerBits, 2);
+		writeLittleEndian(_chunk + 76, 0, 4);
+
+		constexpr uint8_t subFormatGuid[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+		writeLittleEndian(_chunk + 80, _format == SampleFormat::Float32 ? 3 : 1, 2);
+		std::copy_n(subFormatGuid, 14, _chunk + 82);
+
+		std::copy_n("JUNK", 4, _chunk + 96);
+		writeLittleEndian(_chunk + 100, _headerSize - 112, 4);
+
+		std::copy_n("data", 4, _chunk + _headerSize - 8);
+		writeLittleEndian(_chunk + _headerSize - 4, rf64 ? UINT32_MAX : _dataSize, 4);
+
+		return reinterpret_cast<RecordFile*>(_file)->write(0, _chunk, _headerSize);
+	}
+}
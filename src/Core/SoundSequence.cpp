@@ -0,0 +1,506 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	SoundSequence::SoundSequence(uint32_t frequency, uint16_t channelCount, uint64_t preloadCount, double prefetchLength) : SoundBase(),
+		_slots(preloadCount + 1),
+		_mask(0),
+
+		_entries(),
+		_entryMutex(),
+		_entryCount(0),
+		_openedEntryCount(0),
+		_openedSlotCount(0),
+		_closed(false),
+
+		_loadingMutex(),
+		_loadingCondition(),
+		_loaderWaiting(false),
+		_stopping(false),
+		_loadingThread(),
+
+		_realtimeSettings(),
+		_realtimeReport(),
+		_realtimeMutex(),
+		_realtimeCondition(),
+		_realtimeRequested(false),
+
+		_crossfadeLength(0),
+		_playingSlot(0),
+		_playingEntry(0),
+		_playedFrameCount(0),
+		_nextPlayedFrameCount(0),
+		_fadeFrameCount(_undecidedFade),
+		_fadeSamples(_maxChunkFrameCount * channelCount),
+
+		_readTime(0),
+		_underrunCount(0),
+		_underrunFrameCount(0)
+	{
+		assert(frequency != 0);
+		assert(channelCount != 0);
+		assert(preloadCount != 0);
+		assert(prefetchLength > 0.0);
+
+		_frequency = frequency;
+		_channelCount = channelCount;
+		_sampleCount = _openSampleCount;
+
+		// Each slot holds an open decoder and the beginning of its entry: the one playing and the next ones preloaded
+
+		_mask = std::bit_ceil<uint64_t>(std::max<uint64_t>(prefetchLength * _frequency, _maxChunkFrameCount)) - 1;
+		for (Slot& slot : _slots)
+		{
+			slot.ring.resize((_mask + 1) * _channelCount);
+		}
+
+		_loadingThread = std::thread(&SoundSequence::loadingLoop, this);
+	}
+
+	uint64_t SoundSequence::append(const std::filesystem::path& path, SoundFileFormat format)
+	{
+		assert(!_closed.load());
+
+		std::lock_guard lock(_entryMutex);
+
+		_entries.emplace_back(path, format);
+		_entryCount.store(_entries.size(), std::memory_order_release);
+
+		if (_loaderWaiting.load())
+		{
+			_loadingCondition.notify_one();
+		}
+
+		return _entries.size() - 1;
+	}
+
+	void SoundSequence::close()
+	{
+		// The sound ends once every entry appended has been played
+
+		_closed.store(true, std::memory_order_release);
+	}
+
+	void SoundSequence::setCrossfadeDuration(double duration)
+	{
+		assert(duration >= 0.0);
+
+		_crossfadeLength.store(duration * _frequency, std::memory_order_relaxed);
+	}
+
+	double SoundSequence::getCrossfadeDuration() const
+	{
+		return static_cast<double>(_crossfadeLength.load(std::memory_order_relaxed)) / _frequency;
+	}
+
+	uint64_t SoundSequence::getAvailableSampleCount() const
+	{
+		// What is prefetched in the entry playing and in the entries following it without interruption
+
+		const uint64_t playingSlot = _playingSlot.load(std::memory_order_acquire);
+		const uint64_t openedSlotCount = _openedSlotCount.load(std::memory_order_acquire);
+
+		uint64_t availableCount = 0;
+		for (uint64_t i = playingSlot; i < openedSlotCount && i < playingSlot + _slots.size(); ++i)
+		{
+			const Slot& slot = _slots[i % _slots.size()];
+			if (slot.state.load(std::memory_order_acquire) != SlotState::Ready)
+			{
+				break;
+			}
+
+			availableCount += slot.writePosition.load(std::memory_order_acquire) - slot.readPosition.load(std::memory_order_acquire);
+		}
+
+		return availableCount;
+	}
+
+	uint64_t SoundSequence::getEntryCount() const
+	{
+		return _entryCount.load(std::memory_order_acquire);
+	}
+
+	uint64_t SoundSequence::getCurrentEntry() const
+	{
+		return _playingEntry.load(std::memory_order_acquire);
+	}
+
+	uint64_t SoundSequence::getPreloadCount() const
+	{
+		return _slots.size() - 1;
+	}
+
+	bool SoundSequence::isClosed() const
+	{
+		return _closed.load(std::memory_order_acquire);
+	}
+
+	uint64_t SoundSequence::getUnderrunCount() const
+	{
+		return _underrunCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t SoundSequence::getUnderrunFrameCount() const
+	{
+		return _underrunFrameCount.load(std::memory_order_relaxed);
+	}
+
+	RealtimeReport SoundSequence::setRealtimeSettings(const RealtimeSettings& settings)
+	{
+		// The loading thread applies the settings to itself, at most after one wait
+
+		std::unique_lock lock(_realtimeMutex);
+
+		_realtimeSettings = settings;
+		_realtimeRequested.store(true);
+		if (_loaderWaiting.load())
+		{
+			_loadingCondition.notify_one();
+		}
+
+		_realtimeCondition.wait(lock, [&] { return !_realtimeRequested.load(); });
+
+		return _realtimeReport;
+	}
+
+	SoundSequence::~SoundSequence()
+	{
+		_stopping.store(true);
+		{
+			std::lock_guard lock(_loadingMutex);
+			_loadingCondition.notify_all();
+		}
+		_loadingThread.join();
+
+		for (Slot& slot : _slots)
+		{
+			delete slot.file;
+		}
+	}
+
+	void SoundSequence::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
+	{
+		// A sequence cannot seek: frames of a skipped range are dropped, frames asked twice are silent
+
+		if (timeFrom > _readTime)
+		{
+			uint64_t skippedCount = timeFrom - _readTime;
+			while (skippedCount != 0)
+			{
+				const uint64_t count = std::min(skippedCount, _maxChunkFrameCount);
+				if (readFrames(_fadeSamples.data(), count) != count)
+				{
+					break;
+				}
+
+				skippedCount -= count;
+			}
+		}
+		else if (timeFrom < _readTime)
+		{
+			const uint64_t silentCount = std::min(_readTime, timeTo) - timeFrom;
+			std::fill_n(samples, silentCount * _channelCount, 0);
+
+			samples += silentCount * _channelCount;
+			timeFrom += silentCount;
+		}
+
+		// Missing frames are an underrun, unless every entry has been played
+
+		const uint64_t frameCount = timeTo - timeFrom;
+		const uint64_t count = readFrames(samples, frameCount);
+		std::fill_n(samples + count * _channelCount, (frameCount - count) * _channelCount, 0);
+
+		if (_loaderWaiting.load())
+		{
+			_loadingCondition.notify_one();
+		}
+
+		if (count != frameCount)
+		{
+			if (hasEnded())
+			{
+				_playingEntry.store(_entryCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				_sampleCount = timeFrom + count;
+			}
+			else
+			{
+				_underrunCount.fetch_add(1, std::memory_order_relaxed);
+				_underrunFrameCount.fetch_add(frameCount - count, std::memory_order_relaxed);
+			}
+		}
+
+		_readTime = std::max(_readTime, timeTo);
+		_currentSample = _readTime;
+	}
+
+	uint64_t SoundSequence::readFrames(int32_t* samples, uint64_t frameCount)
+	{
+		uint64_t readCount = 0;
+		while (readCount != frameCount)
+		{
+			const uint64_t playingSlot = _playingSlot.load(std::memory_order_relaxed);
+			Slot& slot = _slots[playingSlot % _slots.size()];
+			Slot& nextSlot = _slots[(playingSlot + 1) % _slots.size()];
+
+			// An entry not opened yet is either late or past the end of the sequence
+
+			if (slot.state.load(std::memory_order_acquire) != SlotState::Ready)
+			{
+				break;
+			}
+
+			_playingEntry.store(slot.entry, std::memory_order_relaxed);
+
+			const uint64_t leftCount = slot.frameCount - _playedFrameCount;
+			if (leftCount == 0)
+			{
+				finishEntry();
+				continue;
+			}
+
+			// The crossfade of a boundary is decided when the tail of the entry is reached, it needs the next entry
+			// opened by then. Otherwise the entries are simply put end to end.
+
+			const uint64_t crossfadeLength = _crossfadeLength.load(std::memory_order_relaxed);
+			if (_fadeFrameCount == _undecidedFade && leftCount <= crossfadeLength)
+			{
+				const bool nextReady = nextSlot.state.load(std::memory_order_acquire) == SlotState::Ready;
+				_fadeFrameCount = nextReady ? std::min(leftCount, nextSlot.frameCount) : 0;
+			}
+
+			int32_t* itSamples = samples + readCount * _channelCount;
+			uint64_t count;
+
+			if (_fadeFrameCount != _undecidedFade && leftCount <= _fadeFrameCount)
+			{
+				// Both entries are read at once, the next one fades in linearly over the end of the current one
+
+				const uint64_t maxCount = std::min({ frameCount - readCount, leftCount, _maxChunkFrameCount });
+				const uint64_t availableCount = nextSlot.writePosition.load(std::memory_order_acquire) - nextSlot.readPosition.load(std::memory_order_relaxed);
+
+				count = readSlot(slot, itSamples, std::min(maxCount, availableCount));
+				readSlot(nextSlot, _fadeSamples.data(), count);
+
+				const float fadeStart = static_cast<float>(_fadeFrameCount - leftCount) + 0.5f;
+				for (uint64_t i = 0; i < count; ++i)
+				{
+					const float t = (fadeStart + i) / _fadeFrameCount;
+
+					int32_t* itDst = itSamples + i * _channelCount;
+					const int32_t* itNext = _fadeSamples.data() + i * _channelCount;
+					for (uint16_t j = 0; j < _channelCount; ++j)
+					{
+						const float a = static_cast<float>(itDst[j]);
+						itDst[j] = _crz::floatToSample(a + (static_cast<float>(itNext[j]) - a) * t);
+					}
+				}
+
+				_nextPlayedFrameCount += count;
+			}
+			else
+			{
+				const uint64_t maxCount = leftCount - (_fadeFrameCount == _undecidedFade ? crossfadeLength : _fadeFrameCount);
+				count = readSlot(slot, itSamples, std::min(frameCount - readCount, maxCount));
+			}
+
+			if (count == 0)
+			{
+				break;
+			}
+
+			_playedFrameCount += count;
+			readCount += count;
+		}
+
+		return readCount;
+	}
+
+	uint64_t SoundSequence::readSlot(Slot& slot, int32_t* samples, uint64_t frameCount)
+	{
+		const uint64_t writePosition = slot.writePosition.load(std::memory_order_acquire);
+		const uint64_t readPosition = slot.readPosition.load(std::memory_order_relaxed);
+		const uint64_t count = std::min(frameCount, writePosition - readPosition);
+
+		const uint64_t index = readPosition & _mask;
+		const uint64_t firstCount = std::min(count, _mask + 1 - index);
+		std::copy_n(slot.ring.data() + index * _channelCount, firstCount * _channelCount, samples);
+		std::copy_n(slot.ring.data(), (count - firstCount) * _channelCount, samples + firstCount * _channelCount);
+
+		slot.readPosition.store(readPosition + count, std::memory_order_release);
+
+		return count;
+	}
+
+	void SoundSequence::finishEntry()
+	{
+		// The decoder is closed by the loading thread, the next entry continues where the crossfade left it
+
+		_slots[_playingSlot.load(std::memory_order_relaxed) % _slots.size()].state.store(SlotState::Done, std::memory_order_release);
+		_playingSlot.fetch_add(1, std::memory_order_release);
+
+		_playedFrameCount = _nextPlayedFrameCount;
+		_nextPlayedFrameCount = 0;
+		_fadeFrameCount = _undecidedFade;
+	}
+
+	bool SoundSequence::hasEnded() const
+	{
+		// Entries are opened in order, once the last one is opened every slot it needed is counted
+
+		if (!_closed.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		const uint64_t openedEntryCount = _openedEntryCount.load(std::memory_order_acquire);
+		return openedEntryCount == _entryCount.load(std::memory_order_relaxed) && _playingSlot.load(std::memory_order_relaxed) == _openedSlotCount.load(std::memory_order_relaxed);
+	}
+
+	void SoundSequence::loadingLoop()
+	{
+		// The audio thread notifies without locking, a notification can thus be missed: the wait is bounded to a
+		// fraction of what a slot holds
+
+		const std::chrono::duration<double> timeout(0.125 * (_mask + 1) / _frequency);
+
+		while (!_stopping.load())
+		{
+			if (_realtimeRequested.load())
+			{
+				std::lock_guard lock(_realtimeMutex);
+
+				_realtimeReport = _realtimeSettings.applyToCurrentThread();
+				_realtimeRequested.store(false);
+				_realtimeCondition.notify_all();
+			}
+
+			// Decoders of finished entries are closed here, so that the audio thread never touches files
+
+			bool busy = false;
+			for (Slot& slot : _slots)
+			{
+				if (slot.state.load(std::memory_order_acquire) == SlotState::Done)
+				{
+					delete slot.file;
+					slot.file = nullptr;
+					slot.state.store(SlotState::Free, std::memory_order_release);
+
+					busy = true;
+				}
+			}
+
+			busy = openEntries() || busy;
+			busy = decodeEntries() || busy;
+
+			if (!busy)
+			{
+				std::unique_lock lock(_loadingMutex);
+				_loaderWaiting.store(true);
+				if (!_stopping.load() && !_realtimeRequested.load())
+				{
+					_loadingCondition.wait_for(lock, timeout);
+				}
+				_loaderWaiting.store(false);
+			}
+		}
+	}
+
+	bool SoundSequence::openEntries()
+	{
+		// Opened entries take the slots in turn, once the entry that used a slot has been played. This bounds the number
+		// of decoders open, and keeps the slots in the order of the entries.
+
+		bool opened = false;
+		while (true)
+		{
+			const uint64_t entry = _openedEntryCount.load(std::memory_order_relaxed);
+			const uint64_t slotIndex = _openedSlotCount.load(std::memory_order_relaxed);
+			Slot& slot = _slots[slotIndex % _slots.size()];
+
+			if (entry == _entryCount.load(std::memory_order_acquire) || slot.state.load(std::memory_order_acquire) != SlotState::Free)
+			{
+				return opened;
+			}
+
+			std::filesystem::path path;
+			SoundFileFormat format;
+			{
+				std::lock_guard lock(_entryMutex);
+				path = _entries[entry].first;
+				format = _entries[entry].second;
+			}
+
+			// Files that cannot be read are skipped without taking a slot, the sequence goes on with the next one
+
+			SoundFile* file = new SoundFile(path, format);
+			if (file->isValid() && file->getSampleCount() != 0)
+			{
+				const uint32_t fileFrequency = file->getFrequency();
+				const uint64_t fileSampleCount = file->getSampleCount();
+
+				slot.file = file;
+				slot.entry = entry;
+				slot.frameCount = _frequency == fileFrequency ? fileSampleCount : (fileSampleCount * _frequency + fileFrequency - 1) / fileFrequency;
+				slot.decodedFrameCount = 0;
+				slot.writePosition.store(0, std::memory_order_relaxed);
+				slot.readPosition.store(0, std::memory_order_relaxed);
+				slot.state.store(SlotState::Ready, std::memory_order_release);
+
+				_openedSlotCount.store(slotIndex + 1, std::memory_order_release);
+			}
+			else
+			{
+				delete file;
+			}
+
+			_openedEntryCount.store(entry + 1, std::memory_order_release);
+			opened = true;
+		}
+	}
+
+	bool SoundSequence::decodeEntries()
+	{
+		// Entries are decoded in order from the one playing, so that the next boundary is always prefetched first
+
+		const uint64_t playingSlot = _playingSlot.load(std::memory_order_acquire);
+		const uint64_t openedSlotCount = _openedSlotCount.load(std::memory_order_relaxed);
+
+		bool decoded = false;
+		for (uint64_t i = playingSlot; i < openedSlotCount && !_stopping.load(std::memory_order_relaxed); ++i)
+		{
+			Slot& slot = _slots[i % _slots.size()];
+			if (slot.state.load(std::memory_order_acquire) != SlotState::Ready)
+			{
+				continue;
+			}
+
+			// Samples are converted to the format of the sequence directly in the ring
+
+			const uint64_t writePosition = slot.writePosition.load(std::memory_order_relaxed);
+			const uint64_t freeCount = _mask + 1 - (writePosition - slot.readPosition.load(std::memory_order_acquire));
+			const uint64_t index = writePosition & _mask;
+			const uint64_t count = std::min({ freeCount, slot.frameCount - slot.decodedFrameCount, _mask + 1 - index, _maxChunkFrameCount });
+			if (count == 0)
+			{
+				continue;
+			}
+
+			slot.file->getSamples(_frequency, _channelCount, slot.ring.data() + index * _channelCount, slot.decodedFrameCount, slot.decodedFrameCount + count);
+			slot.decodedFrameCount += count;
+			slot.writePosition.store(writePosition + count, std::memory_order_release);
+
+			decoded = true;
+		}
+
+		return decoded;
+	}
+}
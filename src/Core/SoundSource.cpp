@@ -10,29 +10,93 @@
 
 namespace crz
 {
+	SoundSource::SoundSource() :
+		_channelMatrix(),
+		_rawSamples(),
+		_rawHistory(),
+		_rawHistoryEnd(0),
+		_rawHistoryCount(0),
+		_resampledTime(UINT64_MAX),
+		_reading(false)
+	{
+	}
+
 	double SoundSource::getCurrentTime() const
 	{
 		return static_cast<double>(getCurrentSample()) / getFrequency();
 	}
 
+	void SoundSource::setChannelMatrix(const ChannelMatrix& matrix)
+	{
+		// The matrix is used as long as samples are asked with its output channel count
+
+		assert(matrix.getInputChannelCount() == getChannelCount());
+
+		_channelMatrix = matrix;
+	}
+
+	uint64_t SoundSource::getAvailableSampleCount() const
+	{
+		// Unless the source is produced while it is read, everything up to its end can be read now
+
+		const uint64_t sampleCount = getSampleCount();
+		const uint64_t currentSample = getCurrentSample();
+
+		return sampleCount > currentSample ? sampleCount - currentSample : 0;
+	}
+
+	bool SoundSource::isSilent(uint64_t timeFrom, uint64_t timeTo) const
+	{
+		// Only sources that detect their own silence can tell
+
+		return false;
+	}
+
 	void SoundSource::getSamples(uint32_t frequency, uint16_t channelCount, int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
 	{
-		// Clip timeFrom and timeTo
+		// The conversion state is kept in the source, it thus has a single reader at a time: the output or stream
+		// playing it, the buffer converting it, or the filter placed after it. Readers taking turns are fine, a read
+		// that does not follow the previous one only loses the history kept for resampling.
+
+		[[maybe_unused]] const bool reading = _reading.exchange(true, std::memory_order_acquire);
+		assert(!reading);
+
+		readSamples(frequency, channelCount, samples, timeFrom, timeTo);
+
+		_reading.store(false, std::memory_order_release);
+	}
+
+	void SoundSource::readSamples(uint32_t frequency, uint16_t channelCount, int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
+	{
+		// Clip timeFrom and timeTo, the length of the source is expressed at the asked frequency
 
 		if (timeFrom > timeTo)
 		{
 			std::swap(timeFrom, timeTo);
 		}
 
-		const uint64_t sampleCount = getSampleCount();
+		const uint32_t realFrequency = getFrequency();
+		const uint16_t realChannelCount = getChannelCount();
+
+		// A source without frequency or channels, like a file that failed to open, is silent
+
+		if (realFrequency == 0 || realChannelCount == 0)
+		{
+			std::fill_n(samples, (timeTo - timeFrom) * channelCount, 0);
+			return;
+		}
+
+		const uint64_t realSampleCount = getSampleCount();
+		const uint64_t sampleCount = frequency == realFrequency ? realSampleCount : (realSampleCount * frequency + realFrequency - 1) / realFrequency;
+
 		if (timeFrom >= sampleCount)
 		{
-			std::fill_n(samples, timeTo - timeFrom, 0);
+			std::fill_n(samples, (timeTo - timeFrom) * channelCount, 0);
 			return;
 		}
 		else if (timeTo > sampleCount)
 		{
-			std::fill_n(samples + sampleCount - timeFrom, timeTo - sampleCount, 0);
+			std::fill_n(samples + (sampleCount - timeFrom) * channelCount, (timeTo - sampleCount) * channelCount, 0);
 			timeTo = sampleCount;
 		}
 
@@ -43,80 +107,71 @@ namespace crz
 			return;
 		}
 
-		// If frequency and channel count are the same, shortcut the call as well
-
-		const uint32_t realFrequency = getFrequency();
-		const uint16_t realChannelCount = getChannelCount();
+		// The standard matrix between both layouts is computed once, and kept while the channel counts do not change
 
-		if (frequency == realFrequency && channelCount == realChannelCount)
+		if (_channelMatrix.getInputChannelCount() != realChannelCount || _channelMatrix.getOutputChannelCount() != channelCount)
 		{
-			getRawSamples(samples, timeFrom, timeTo);
-			return;
+			_channelMatrix = ChannelMatrix(realChannelCount, channelCount);
 		}
 
-		// Compute real sample indices (based on sound frequency instead of output frequency)
+		// If frequency and channels are the same, shortcut the call as well
 
-		const uint64_t realTimeFrom = timeFrom * realFrequency / frequency;
-		uint64_t realTimeTo = timeTo * realFrequency / frequency;
-
-		if (realTimeFrom == realTimeTo)
+		if (frequency == realFrequency)
 		{
-			++realTimeTo;
-		}
+			if (_channelMatrix.isIdentity())
+			{
+				getRawSamples(samples, timeFrom, timeTo);
+			}
+			else
+			{
+				const uint64_t frameCount = timeTo - timeFrom;
+				if (_rawSamples.size() < frameCount * realChannelCount)
+				{
+					_rawSamples.resize(frameCount * realChannelCount);
+				}
 
-		// TODO: Comment this
+				getRawSamples(_rawSamples.data(), timeFrom, timeTo);
+				_channelMatrix.apply(samples, _rawSamples.data(), frameCount);
+			}
 
-		int32_t* rawSamples = new int32_t[(realTimeTo - realTimeFrom) * std::max(channelCount, realChannelCount)];
-		getRawSamples(rawSamples, realTimeFrom, realTimeTo);
+			return;
+		}
 
-		if (channelCount > realChannelCount)
-		{
-			const uint16_t srcDecrement = 2 * realChannelCount;
-			const uint16_t dstDecrement = 2 * channelCount;
+		// Output frame t reads the source at t * realFrequency / frequency. Sources are read contiguously: the last two
+		// frames of the previous read are kept, because the first frame of this block can fall between them.
 
+		const uint64_t firstFrame = timeFrom * realFrequency / frequency;
+		const uint64_t endFrame = std::min((timeTo - 1) * realFrequency / frequency + 2, realSampleCount);
+		const uint64_t frameCount = endFrame - firstFrame;
 
-			int32_t* itDst = rawSamples + (realTimeTo - realTimeFrom - 1) * channelCount;
-			const int32_t* itSrc = rawSamples + (realTimeTo - realTimeFrom - 1) * realChannelCount;
-			const int32_t* const itEnd = rawSamples - realChannelCount;
+		if (_rawSamples.size() < frameCount * realChannelCount)
+		{
+			_rawSamples.resize(frameCount * realChannelCount);
+		}
 
-			for (; itSrc != itEnd; itSrc -= srcDecrement, itDst -= dstDecrement)
-			{
-				uint16_t i = 0;
-				for (; i < realChannelCount; ++i, ++itSrc, ++itDst)
-				{
-					*itDst = *itSrc;
-				}
+		uint64_t readFrom = firstFrame;
+		if (timeFrom == _resampledTime && firstFrame < _rawHistoryEnd && firstFrame + _rawHistoryCount >= _rawHistoryEnd)
+		{
+			readFrom = std::min(_rawHistoryEnd, endFrame);
 
-				for (; i < channelCount; ++i, ++itDst)
-				{
-					*itDst = *(itDst - realChannelCount);
-				}
-			}
+			const int32_t* itHistory = _rawHistory.data() + (_rawHistoryCount - (_rawHistoryEnd - firstFrame)) * realChannelCount;
+			std::copy_n(itHistory, (readFrom - firstFrame) * realChannelCount, _rawSamples.begin());
 		}
-		else if (realChannelCount > channelCount)
-		{
-			const uint16_t srcIncrement = realChannelCount - channelCount;
 
-			int32_t* itDst = rawSamples + channelCount;
-			const int32_t* itSrc = rawSamples + realChannelCount;
-			const int32_t* const itEnd = rawSamples + (realTimeTo - realTimeFrom) * realChannelCount;
+		if (endFrame > readFrom)
+		{
+			getRawSamples(_rawSamples.data() + (readFrom - firstFrame) * realChannelCount, readFrom, endFrame);
 
-			for (; itSrc != itEnd; itSrc += srcIncrement)
-			{
-				for (uint16_t i = 0; i < channelCount; ++i, ++itSrc, ++itDst)
-				{
-					*itDst = *itSrc;
-				}
-			}
+			_rawHistoryCount = std::min<uint64_t>(frameCount, 2);
+			_rawHistoryEnd = endFrame;
+			_rawHistory.resize(2 * realChannelCount);
+			std::copy_n(_rawSamples.data() + (frameCount - _rawHistoryCount) * realChannelCount, _rawHistoryCount * realChannelCount, _rawHistory.begin());
 		}
 
-		scp::Matrix<int32_t>* samplesMatrix = scp::Matrix<int32_t>::createAroundMemory(timeTo - timeFrom, channelCount, samples);
-		scp::Matrix<int32_t>* rawSamplesMatrix = scp::Matrix<int32_t>::createAroundMemory(realTimeTo - realTimeFrom, channelCount, rawSamples);
+		_resampledTime = timeTo;
 
-		samplesMatrix->resize<float, scp::InterpolationMethod::Linear>(*rawSamplesMatrix);
+		// Interpolation and channel mixing are done in the same pass
 
-		delete samplesMatrix;
-		delete rawSamplesMatrix;
-		delete[] rawSamples;
+		_channelMatrix.applyResampled(samples, _rawSamples.data(), frameCount, timeTo - timeFrom, timeFrom * realFrequency - firstFrame * frequency, realFrequency, frequency);
 	}
 }
@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	SoundStream::SoundStream(uint32_t frequency, uint16_t channelCount, double bufferLength) : SoundBase(),
+		_ring(),
+		_mask(0),
+		_lowWatermark(0),
+		_highWatermark(0),
+
+		_writePosition(0),
+		_readPosition(0),
+		_producerMutex(),
+		_producerCondition(),
+		_producerWaiting(false),
+		_closed(false),
+
+		_readTime(0),
+		_underrunCount(0),
+		_underrunFrameCount(0)
+	{
+		assert(frequency != 0);
+		assert(channelCount != 0);
+		assert(bufferLength > 0.0);
+
+		_frequency = frequency;
+		_channelCount = channelCount;
+		_sampleCount = _openSampleCount;
+
+		_mask = std::bit_ceil<uint64_t>(bufferLength * _frequency) - 1;
+		_ring.resize((_mask + 1) * _channelCount);
+
+		setWatermarks(0.25 * bufferLength, 0.75 * bufferLength);
+	}
+
+	void SoundStream::setWatermarks(double lowWatermark, double highWatermark)
+	{
+		assert(lowWatermark >= 0.0);
+		assert(lowWatermark <= highWatermark);
+
+		_highWatermark = std::min<uint64_t>(highWatermark * _frequency, _mask + 1);
+		_lowWatermark = std::min<uint64_t>(lowWatermark * _frequency, _highWatermark);
+	}
+
+	double SoundStream::getLowWatermark() const
+	{
+		return static_cast<double>(_lowWatermark) / _frequency;
+	}
+
+	double SoundStream::getHighWatermark() const
+	{
+		return static_cast<double>(_highWatermark) / _frequency;
+	}
+
+	uint64_t SoundStream::push(const int32_t* samples, uint64_t frameCount, bool blocking)
+	{
+		// Only one thread may push at a time, the ring is single producer single consumer
+
+		uint64_t pushedCount = 0;
+		while (pushedCount != frameCount && !_closed.load(std::memory_order_relaxed))
+		{
+			const uint64_t writePosition = _writePosition.load(std::memory_order_relaxed);
+			uint64_t readPosition = _readPosition.load(std::memory_order_acquire);
+
+			// A blocking producer is paced by the consumer: once above the high watermark, it waits for the buffer to
+			// go down to the low watermark
+
+			if (blocking && writePosition - readPosition >= _highWatermark)
+			{
+				// The consumer notifies without locking, a notification can thus be missed: the wait is bounded to a
+				// fraction of what the buffer holds
+
+				const std::chrono::duration<double> timeout(0.25 * _lowWatermark / _frequency + 0.001);
+
+				std::unique_lock lock(_producerMutex);
+				_producerWaiting.store(true);
+				while (writePosition - _readPosition.load() > _lowWatermark && !_closed.load())
+				{
+					_producerCondition.wait_for(lock, timeout);
+				}
+				_producerWaiting.store(false);
+
+				continue;
+			}
+
+			const uint64_t limit = blocking ? _highWatermark : _mask + 1;
+			const uint64_t count = std::min(frameCount - pushedCount, limit - std::min(limit, writePosition - readPosition));
+			if (count == 0)
+			{
+				break;
+			}
+
+			const uint64_t index = writePosition & _mask;
+			const uint64_t firstCount = std::min(count, _mask + 1 - index);
+			const int32_t* it = samples + pushedCount * _channelCount;
+			std::copy_n(it, firstCount * _channelCount, _ring.data() + index * _channelCount);
+			std::copy_n(it + firstCount * _channelCount, (count - firstCount) * _channelCount, _ring.data());
+
+			_writePosition.store(writePosition + count, std::memory_order_release);
+			pushedCount += count;
+		}
+
+		return pushedCount;
+	}
+
+	void SoundStream::close()
+	{
+		// The sound ends once what was pushed has been played, blocked producers are released
+
+		_closed.store(true);
+
+		std::lock_guard lock(_producerMutex);
+		_producerCondition.notify_all();
+	}
+
+	uint64_t SoundStream::getAvailableSampleCount() const
+	{
+		// The sample count of an open stream is not its length, only what was pushed can be read
+
+		return getBufferedFrameCount();
+	}
+
+	uint64_t SoundStream::getBufferedFrameCount() const
+	{
+		return _writePosition.load(std::memory_order_acquire) - _readPosition.load(std::memory_order_acquire);
+	}
+
+	uint64_t SoundStream::getCapacity() const
+	{
+		return _mask + 1;
+	}
+
+	bool SoundStream::isBelowLowWatermark() const
+	{
+		return getBufferedFrameCount() < _lowWatermark;
+	}
+
+	bool SoundStream::isClosed() const
+	{
+		return _closed.load(std::memory_order_acquire);
+	}
+
+	uint64_t SoundStream::getUnderrunCount() const
+	{
+		return _underrunCount.load(std::memory_order_relaxed);
+	}
+
+	uint64_t SoundStream::getUnderrunFrameCount() const
+	{
+		return _underrunFrameCount.load(std::memory_order_relaxed);
+	}
+
+	SoundStream::~SoundStream()
+	{
+		close();
+	}
+
+	void SoundStream::getRawSamples(int32_t* samples, uint64_t timeFrom, uint64_t timeTo)
+	{
+		const uint64_t writePosition = _writePosition.load(std::memory_order_acquire);
+		uint64_t readPosition = _readPosition.load(std::memory_order_relaxed);
+
+		// A stream cannot seek: frames of a skipped range are dropped, frames asked twice are silent
+
+		if (timeFrom > _readTime)
+		{
+			readPosition += std::min(timeFrom - _readTime, writePosition - readPosition);
+		}
+		else if (timeFrom < _readTime)
+		{
+			const uint64_t silentCount = std::min(_readTime, timeTo) - timeFrom;
+			std::fill_n(samples, silentCount * _channelCount, 0);
+
+			samples += silentCount * _channelCount;
+			timeFrom += silentCount;
+		}
+
+		// Copy what is available, missing frames are an underrun
+
+		const uint64_t frameCount = timeTo - timeFrom;
+		const uint64_t count = std::min(frameCount, writePosition - readPosition);
+
+		const uint64_t index = readPosition & _mask;
+		const uint64_t firstCount = std::min(count, _mask + 1 - index);
+		std::copy_n(_ring.data() + index * _channelCount, firstCount * _channelCount, samples);
+		std::copy_n(_ring.data(), (count - firstCount) * _channelCount, samples + firstCount * _channelCount);
+		std::fill_n(samples + count * _channelCount, (frameCount - count) * _channelCount, 0);
+
+		// Waking the producer costs a system call, it is only done when it waits
+
+		_readPosition.store(readPosition + count);
+		if (_producerWaiting.load())
+		{
+			_producerCondition.notify_one();
+		}
+
+		if (count != frameCount)
+		{
+			if (_closed.load(std::memory_order_acquire))
+			{
+				// Everything pushed was played, the sound now has a length
+
+				_sampleCount = timeFrom + count;
+			}
+			else
+			{
+				_underrunCount.fetch_add(1, std::memory_order_relaxed);
+				_underrunFrameCount.fetch_add(frameCount - count, std::memory_order_relaxed);
+			}
+		}
+
+		_readTime = std::max(_readTime, timeTo);
+		_currentSample = _readTime;
+	}
+}
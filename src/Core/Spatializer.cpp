@@ -0,0 +1,312 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	namespace
+	{
+		constexpr float pi = std::numbers::pi_v<float>;
+
+		float getStandardAzimuth(Speaker speaker, uint16_t channelCount)
+		{
+			// Azimuths are clockwise from the front, quadraphonic speakers are on the diagonals
+
+			switch (speaker)
+			{
+				case Speaker::FrontLeft:
+					return -pi / 6;
+				case Speaker::FrontRight:
+					return pi / 6;
+				case Speaker::FrontCenter:
+					return 0.f;
+				case Speaker::BackLeft:
+					return channelCount == 4 ? -3 * pi / 4 : -11 * pi / 18;
+				case Speaker::BackRight:
+					return channelCount == 4 ? 3 * pi / 4 : 11 * pi / 18;
+				case Speaker::SideLeft:
+					return -pi / 2;
+				case Speaker::SideRight:
+					return pi / 2;
+				default:
+					return std::numeric_limits<float>::quiet_NaN();
+			}
+		}
+
+		float wrapAzimuth(float azimuth)
+		{
+			return azimuth - 2 * pi * std::floor((azimuth + pi) / (2 * pi));
+		}
+	}
+
+	Spatializer::Spatializer(uint16_t channelCount) :
+		_channelCount(channelCount),
+		_azimuths(channelCount),
+		_panningLaw(PanningLaw::Vbap),
+
+		_referenceDistance(1.f),
+		_maxDistance(std::numeric_limits<float>::max()),
+		_rolloffFactor(1.f),
+
+		_listenerX(0.f),
+		_listenerY(0.f),
+		_listenerZ(0.f),
+		_listenerYaw(0.f),
+
+		_pairs(),
+		_frontOnly(false),
+		_minAzimuth(-pi),
+		_maxAzimuth(pi)
+	{
+		assert(channelCount != 0);
+
+		// Speakers of standard layouts are placed as recommended by ITU-R BS.775, others are spread evenly
+
+		const Speaker* speakers;
+		if (channelCount == 1)
+		{
+			_azimuths[0] = 0.f;
+		}
+		else if (ChannelMatrix::getStandardLayout(channelCount, speakers))
+		{
+			for (uint16_t i = 0; i < channelCount; ++i)
+			{
+				_azimuths[i] = getStandardAzimuth(speakers[i], channelCount);
+			}
+		}
+		else
+		{
+			for (uint16_t i = 0; i < channelCount; ++i)
+			{
+				_azimuths[i] = wrapAzimuth(2 * pi * i / channelCount);
+			}
+		}
+
+		computePairs();
+	}
+
+	void Spatializer::setSpeakerAzimuth(uint16_t channel, float azimuth)
+	{
+		assert(channel < _channelCount);
+		assert(std::isfinite(azimuth));
+
+		_azimuths[channel] = wrapAzimuth(azimuth);
+		computePairs();
+	}
+
+	void Spatializer::removeSpeaker(uint16_t channel)
+	{
+		assert(channel < _channelCount);
+
+		_azimuths[channel] = std::numeric_limits<float>::quiet_NaN();
+		computePairs();
+	}
+
+	float Spatializer::getSpeakerAzimuth(uint16_t channel) const
+	{
+		assert(channel < _channelCount);
+
+		return _azimuths[channel];
+	}
+
+	void Spatializer::setPanningLaw(PanningLaw panningLaw)
+	{
+		_panningLaw = panningLaw;
+	}
+
+	PanningLaw Spatializer::getPanningLaw() const
+	{
+		return _panningLaw;
+	}
+
+	void Spatializer::setDistanceModel(float referenceDistance, float maxDistance, float rolloffFactor)
+	{
+		assert(referenceDistance > 0.f);
+		assert(maxDistance >= referenceDistance);
+		assert(rolloffFactor >= 0.f);
+
+		_referenceDistance = referenceDistance;
+		_maxDistance = maxDistance;
+		_rolloffFactor = rolloffFactor;
+	}
+
+	void Spatializer::setListener(float x, float y, float z, float yaw)
+	{
+		_listenerX = x;
+		_listenerY = y;
+		_listenerZ = z;
+		_listenerYaw = yaw;
+	}
+
+	uint16_t Spatializer::getChannelCount() const
+	{
+		return _channelCount;
+	}
+
+	void Spatializer::computeGains(const float* xs, const float* ys, const float* zs, uint64_t voiceCount, uint16_t* firstChannels, uint16_t* secondChannels, float* firstGains, float* secondGains) const
+	{
+		// First pass over the structure of arrays: distance attenuation (inverse distance, clamped) is stored in the
+		// first gains and azimuth relative to the listener in the second gains
+
+		for (uint64_t i = 0; i < voiceCount; ++i)
+		{
+			const float dx = xs[i] - _listenerX;
+			const float dy = ys[i] - _listenerY;
+			const float dz = zs[i] - _listenerZ;
+			const float distance = std::clamp(std::sqrt(dx * dx + dy * dy + dz * dz), _referenceDistance, _maxDistance);
+
+			firstGains[i] = _referenceDistance / (_referenceDistance + _rolloffFactor * (distance - _referenceDistance));
+			secondGains[i] = std::atan2(dx, dy) - _listenerYaw;
+		}
+
+		// Second pass: each voice is panned between the two speakers surrounding it
+
+		for (uint64_t i = 0; i < voiceCount; ++i)
+		{
+			const float attenuation = firstGains[i];
+
+			if (_pairs.empty())
+			{
+				const uint16_t channel = std::find_if(_azimuths.begin(), _azimuths.end(), [](float x) { return !std::isnan(x); }) - _azimuths.begin();
+
+				firstChannels[i] = channel == _channelCount ? 0 : channel;
+				secondChannels[i] = firstChannels[i];
+				firstGains[i] = channel == _channelCount ? 0.f : attenuation;
+				secondGains[i] = 0.f;
+
+				continue;
+			}
+
+			// Layouts without rear speakers fold the sources behind the listener to the front
+
+			float azimuth = wrapAzimuth(secondGains[i]);
+			if (_frontOnly)
+			{
+				if (azimuth > pi / 2)
+				{
+					azimuth = pi - azimuth;
+				}
+				else if (azimuth < -pi / 2)
+				{
+					azimuth = -pi - azimuth;
+				}
+
+				azimuth = std::clamp(azimuth, _minAzimuth, _maxAzimuth);
+			}
+
+			auto it = std::upper_bound(_pairs.begin(), _pairs.end(), azimuth, [](float x, const SpeakerPair& pair) { return x < pair.azimuth; });
+			const SpeakerPair& pair = it == _pairs.begin() ? _pairs.back() : *(it - 1);
+
+			const float offset = azimuth - pair.azimuth < 0.f ? azimuth - pair.azimuth + 2 * pi : azimuth - pair.azimuth;
+			const float t = std::clamp(offset / pair.span, 0.f, 1.f);
+
+			float g1, g2;
+			if (_panningLaw == PanningLaw::Vbap && pair.invertible)
+			{
+				// Gains are the coordinates of the source direction in the base of the two speaker directions,
+				// normalized to keep a constant power
+
+				const float px = std::sin(azimuth);
+				const float py = std::cos(azimuth);
+
+				g1 = std::max(pair.inverseBase[0] * px + pair.inverseBase[1] * py, 0.f);
+				g2 = std::max(pair.inverseBase[2] * px + pair.inverseBase[3] * py, 0.f);
+
+				const float norm = std::sqrt(g1 * g1 + g2 * g2);
+				g1 /= norm;
+				g2 /= norm;
+			}
+			else
+			{
+				g1 = std::cos(t * pi / 2);
+				g2 = std::sin(t * pi / 2);
+			}
+
+			firstChannels[i] = pair.firstChannel;
+			secondChannels[i] = pair.secondChannel;
+			firstGains[i] = g1 * attenuation;
+			secondGains[i] = g2 * attenuation;
+		}
+	}
+
+	void Spatializer::computePairs()
+	{
+		_pairs.clear();
+		_frontOnly = false;
+		_minAzimuth = -pi;
+		_maxAzimuth = pi;
+
+		std::vector<std::pair<float, uint16_t>> speakers;
+		for (uint16_t i = 0; i < _channelCount; ++i)
+		{
+			if (!std::isnan(_azimuths[i]))
+			{
+				speakers.emplace_back(_azimuths[i], i);
+			}
+		}
+
+		if (speakers.size() < 2)
+		{
+			return;
+		}
+
+		// Consecutive speakers around the listener form the pairs, the last one wraps around behind
+
+		std::sort(speakers.begin(), speakers.end());
+
+		uint64_t widestPair = 0;
+		for (uint64_t i = 0; i < speakers.size(); ++i)
+		{
+			const std::pair<float, uint16_t>& first = speakers[i];
+			const std::pair<float, uint16_t>& second = speakers[(i + 1) % speakers.size()];
+
+			SpeakerPair pair;
+			pair.azimuth = first.first;
+			pair.span = i + 1 == speakers.size() ? second.first + 2 * pi - first.first : second.first - first.first;
+			pair.firstChannel = first.second;
+			pair.secondChannel = second.second;
+			pair.invertible = pair.span > 0.f && pair.span < 0.95f * pi;
+			pair.inverseBase = { 0.f, 0.f, 0.f, 0.f };
+
+			// Pairs too wide for their base to be inverted are panned with the constant power law
+
+			if (pair.invertible)
+			{
+				const float l1x = std::sin(first.first), l1y = std::cos(first.first);
+				const float l2x = std::sin(second.first), l2y = std::cos(second.first);
+				const float det = l1x * l2y - l2x * l1y;
+
+				pair.inverseBase = { l2y / det, -l2x / det, -l1y / det, l1x / det };
+			}
+
+			if (!_pairs.empty() && pair.span > _pairs[widestPair].span)
+			{
+				widestPair = i;
+			}
+
+			_pairs.push_back(pair);
+		}
+
+		// A gap wider than a half circle means there are no speakers behind: it is not panned across
+
+		if (_pairs[widestPair].span > pi)
+		{
+			const float minAzimuth = _pairs[(widestPair + 1) % _pairs.size()].azimuth;
+			const float maxAzimuth = _pairs[widestPair].azimuth;
+
+			if (minAzimuth <= maxAzimuth)
+			{
+				_frontOnly = true;
+				_minAzimuth = minAzimuth;
+				_maxAzimuth = maxAzimuth;
+				_pairs.erase(_pairs.begin() + widestPair);
+			}
+		}
+	}
+}
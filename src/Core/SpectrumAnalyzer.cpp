@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	float SpectrumFrame::getMagnitude(uint16_t channel, uint64_t bin) const
+	{
+		assert(channel < channelCount);
+		assert(bin < binCount);
+
+		return magnitudes[channel * binCount + bin];
+	}
+
+	SpectrumAnalyzer::SpectrumAnalyzer(const BroadcastRing& ring, uint32_t frequency, uint64_t frameSize, uint64_t hopSize, SpectrumWindow window) :
+		_reader(ring),
+		_frequency(frequency),
+		_channelCount(ring.getChannelCount()),
+		_frameSize(frameSize),
+		_hopSize(hopSize),
+
+		_fft(nullptr),
+		_window(frameSize),
+		_magnitudeScale(1.f),
+
+		_hopSamples(hopSize * _channelCount),
+		_hopFrameCount(0),
+		_history(frameSize * _channelCount, 0.f),
+		_historyFrameCount(0),
+		_windowedSamples(frameSize),
+		_spectrumReals(frameSize / 2 + 1),
+		_spectrumImags(frameSize / 2 + 1),
+		_fftScratch(frameSize),
+
+		_framesMutex(),
+		_frames(),
+		_latestFrame(),
+		_droppedFrameCount(0),
+
+		_running(true),
+		_analysisThread()
+	{
+		assert(frequency != 0);
+		assert(frameSize >= 4 && std::has_single_bit(frameSize));
+		assert(hopSize != 0 && hopSize <= frameSize);
+		assert(hopSize <= ring.getReadableFrameCount());
+
+		_fft = new _crz::Fft(frameSize);
+
+		// Periodic windows, the magnitudes are scaled so that a full scale sine centered on a bin reads 1
+
+		double windowSum = 0.0;
+		for (uint64_t i = 0; i < frameSize; ++i)
+		{
+			const double x = 2.0 * std::numbers::pi * i / frameSize;
+			switch (window)
+			{
+				case SpectrumWindow::Rectangular:
+					_window[i] = 1.f;
+					break;
+				case SpectrumWindow::Hann:
+					_window[i] = 0.5 - 0.5 * std::cos(x);
+					break;
+				case SpectrumWindow::BlackmanHarris:
+					_window[i] = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2 * x) - 0.01168 * std::cos(3 * x);
+					break;
+			}
+
+			windowSum += _window[i];
+		}
+
+		_magnitudeScale = 2.0 / windowSum;
+
+		_latestFrame.position = 0;
+		_latestFrame.channelCount = _channelCount;
+		_latestFrame.binCount = getBinCount();
+
+		_analysisThread = std::thread(&SpectrumAnalyzer::analysisLoop, this);
+	}
+
+	bool SpectrumAnalyzer::popFrame(SpectrumFrame& frame)
+	{
+		std::unique_lock lock(_framesMutex);
+
+		if (_frames.empty())
+		{
+			return false;
+		}
+
+		frame = std::move(_frames.front());
+		_frames.pop_front();
+
+		return true;
+	}
+
+	bool SpectrumAnalyzer::getLatestFrame(SpectrumFrame& frame) const
+	{
+		std::unique_lock lock(_framesMutex);
+
+		if (_latestFrame.magnitudes.empty())
+		{
+			return false;
+		}
+
+		frame = _latestFrame;
+
+		return true;
+	}
+
+	uint32_t SpectrumAnalyzer::getFrequency() const
+	{
+		return _frequency;
+	}
+
+	uint64_t SpectrumAnalyzer::getFrameSize() const
+	{
+		return _frameSize;
+	}
+
+	uint64_t SpectrumAnalyzer::getHopSize() const
+	{
+		return _hopSize;
+	}
+
+	uint64_t SpectrumAnalyzer::getBinCount() const
+	{
+		return _frameSize / 2 + 1;
+	}
+
+	float SpectrumAnalyzer::getBinFrequency(uint64_t bin) const
+	{
+		return static_cast<float>(bin) * _frequency / _frameSize;
+	}
+
+	uint64_t SpectrumAnalyzer::getDroppedFrameCount() const
+	{
+		std::unique_lock lock(_framesMutex);
+
+		return _droppedFrameCount;
+	}
+
+	SpectrumAnalyzer::~SpectrumAnalyzer()
+	{
+		_running.store(false, std::memory_order_relaxed);
+		_analysisThread.join();
+
+		delete reinterpret_cast<_crz::Fft*>(_fft);
+	}
+
+	void SpectrumAnalyzer::analysisLoop()
+	{
+		const std::chrono::duration<double> period(0.5 * _hopSize / _frequency);
+		uint64_t skippedFrameCount = 0;
+
+		while (_running.load(std::memory_order_relaxed))
+		{
+			// Collect a hop of frames from the ring. The render path only writes to it, all the work is done here.
+
+			const uint64_t maxFrameCount = _hopSize - _hopFrameCount;
+
+			const BroadcastView view = _reader.acquire(maxFrameCount);
+			int32_t* it = _hopSamples.data() + _hopFrameCount * _channelCount;
+			for (uint8_t i = 0; i < 2; ++i)
+			{
+				it = std::copy_n(view.samples[i], view.frameCounts[i] * _channelCount, it);
+			}
+
+			const uint64_t frameCount = view.getFrameCount();
+			const bool intact = _reader.release(view);
+
+			// Frames lost because this thread was late break the continuity of the signal, the history starts over
+
+			if (!intact || _reader.getSkippedFrameCount() != skippedFrameCount)
+			{
+				skippedFrameCount = _reader.getSkippedFrameCount();
+				_hopFrameCount = 0;
+				_historyFrameCount = 0;
+				continue;
+			}
+
+			_hopFrameCount += frameCount;
+
+			if (_hopFrameCount == _hopSize)
+			{
+				for (uint16_t i = 0; i < _channelCount; ++i)
+				{
+					float* history = _history.data() + i * _frameSize;
+					std::copy(history + _hopSize, history + _frameSize, history);
+					_crz::deinterleave(history + _frameSize - _hopSize, _hopSamples.data() + i, _hopSize, _channelCount, 1.f / 2147483648.f);
+				}
+
+				_hopFrameCount = 0;
+				_historyFrameCount = std::min(_historyFrameCount + _hopSize, _frameSize);
+
+				if (_historyFrameCount == _frameSize)
+				{
+					analyze(_reader.getPosition() - _frameSize);
+				}
+			}
+			else if (frameCount < maxFrameCount)
+			{
+				std::this_thread::sleep_for(period);
+			}
+		}
+	}
+
+	void SpectrumAnalyzer::analyze(uint64_t position)
+	{
+		const _crz::Fft* fft = reinterpret_cast<const _crz::Fft*>(_fft);
+		const uint64_t binCount = getBinCount();
+
+		SpectrumFrame frame;
+		frame.position = position;
+		frame.channelCount = _channelCount;
+		frame.binCount = binCount;
+		frame.magnitudes.resize(_channelCount * binCount);
+
+		for (uint16_t i = 0; i < _channelCount; ++i)
+		{
+			std::copy_n(_history.data() + i * _frameSize, _frameSize, _windowedSamples.data());
+			_crz::multiplyInPlace(_windowedSamples.data(), _window.data(), _frameSize);
+
+			fft->transform(_spectrumReals.data(), _spectrumImags.data(), _windowedSamples.data(), _fftScratch.data());
+			_crz::computeMagnitudes(frame.magnitudes.data() + i * binCount, _spectrumReals.data(), _spectrumImags.data(), binCount, _magnitudeScale);
+		}
+
+		// Frames nobody pops are dropped, oldest first, the latest one is always available
+
+		std::unique_lock lock(_framesMutex);
+
+		_latestFrame = frame;
+
+		if (_frames.size() == _maxPendingFrameCount)
+		{
+			_frames.pop_front();
+			++_droppedFrameCount;
+		}
+
+		_frames.push_back(std::move(frame));
+	}
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+namespace crz
+{
+	double RenderTimeHistogram::getBucketLowerBound(uint64_t bucket)
+	{
+		// Bucket 0 holds render times under a microsecond, bucket i holds times in [2^(i-1), 2^i) microseconds
+
+		return bucket == 0 ? 0.0 : std::ldexp(1e-6, bucket - 1);
+	}
+
+	double RenderTimeHistogram::getMeanTime() const
+	{
+		return renderCount == 0 ? 0.0 : totalTime / renderCount;
+	}
+
+	StreamMonitor::StreamMonitor() :
+		_callbackCount(0),
+		_inputUnderflowCount(0),
+		_inputOverflowCount(0),
+		_outputUnderflowCount(0),
+		_outputOverflowCount(0),
+		_silentBlockCount(0),
+		_droppedFrameCount(0),
+
+		_blockRenderTimes(),
+		_voiceRenderTimes()
+	{
+	}
+
+	void StreamMonitor::addCallback(unsigned long statusFlags)
+	{
+		// Counters are only written by the audio threads and read by anyone, relaxed ordering is enough
+
+		_callbackCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (statusFlags & paInputUnderflow)
+		{
+			_inputUnderflowCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (statusFlags & paInputOverflow)
+		{
+			_inputOverflowCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (statusFlags & paOutputUnderflow)
+		{
+			_outputUnderflowCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (statusFlags & paOutputOverflow)
+		{
+			_outputOverflowCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void StreamMonitor::addSilentBlock()
+	{
+		_silentBlockCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void StreamMonitor::addDroppedFrames(uint64_t frameCount)
+	{
+		_droppedFrameCount.fetch_add(frameCount, std::memory_order_relaxed);
+	}
+
+	void StreamMonitor::addBlockRenderTime(double time)
+	{
+		addRenderTime(_blockRenderTimes, time);
+	}
+
+	void StreamMonitor::addVoiceRenderTime(double time)
+	{
+		addRenderTime(_voiceRenderTimes, time);
+	}
+
+	StreamStatistics StreamMonitor::getStatistics(void* stream) const
+	{
+		StreamStatistics statistics;
+
+		statistics.callbackCount = _callbackCount.load(std::memory_order_relaxed);
+		statistics.inputUnderflowCount = _inputUnderflowCount.load(std::memory_order_relaxed);
+		statistics.inputOverflowCount = _inputOverflowCount.load(std::memory_order_relaxed);
+		statistics.outputUnderflowCount = _outputUnderflowCount.load(std::memory_order_relaxed);
+		statistics.outputOverflowCount = _outputOverflowCount.load(std::memory_order_relaxed);
+		statistics.silentBlockCount = _silentBlockCount.load(std::memory_order_relaxed);
+		statistics.droppedFrameCount = _droppedFrameCount.load(std::memory_order_relaxed);
+		statistics.cpuLoad = stream ? Pa_GetStreamCpuLoad(reinterpret_cast<PaStream*>(stream)) : 0.0;
+
+		copyHistogram(_blockRenderTimes, statistics.blockRenderTimes);
+		copyHistogram(_voiceRenderTimes, statistics.voiceRenderTimes);
+
+		return statistics;
+	}
+
+	void StreamMonitor::addRenderTime(Histogram& histogram, double time)
+	{
+		const uint64_t nanoseconds = time * 1e9;
+		const uint64_t bucket = std::min<uint64_t>(std::bit_width(nanoseconds / 1000), RenderTimeHistogram::bucketCount - 1);
+
+		histogram.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+		histogram.renderCount.fetch_add(1, std::memory_order_relaxed);
+		histogram.totalTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+		// Only one thread renders for a given stream, so the maximum can be updated without compare-exchange
+
+		if (nanoseconds > histogram.maxTime.load(std::memory_order_relaxed))
+		{
+			histogram.maxTime.store(nanoseconds, std::memory_order_relaxed);
+		}
+	}
+
+	void StreamMonitor::copyHistogram(const Histogram& histogram, RenderTimeHistogram& result)
+	{
+		for (uint64_t i = 0; i < RenderTimeHistogram::bucketCount; ++i)
+		{
+			result.counts[i] = histogram.counts[i].load(std::memory_order_relaxed);
+		}
+
+		result.renderCount = histogram.renderCount.load(std::memory_order_relaxed);
+		result.totalTime = histogram.totalTime.load(std::memory_order_relaxed) * 1e-9;
+		result.maxTime = histogram.maxTime.load(std::memory_order_relaxed) * 1e-9;
+	}
+}
@@ -0,0 +1,368 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! \file
+//! \author Pélérin Marius
+//! \copyright The MIT License (MIT)
+//! \date 2022-2023
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <Crozet/Core/Core.hpp>
+#include <Crozet/Private/Private.hpp>
+
+#include <fstream>
+#include <iomanip>
+
+namespace crz
+{
+	namespace
+	{
+		struct TraceEvent
+		{
+			const char* name;
+			uint64_t id;
+			uint64_t start;
+			uint64_t end;
+		};
+
+		// Each thread writes its events in its own ring, only the write index is shared with the thread dumping them.
+		// The ring belongs to a generation: clearing or resizing starts a new one, and each thread resets its own ring
+		// when it sees it on its next event.
+
+		struct ThreadBuffer
+		{
+			uint64_t threadIndex;
+			std::string threadName;
+			std::vector<TraceEvent> events;
+			std::atomic<uint64_t> writeIndex;
+			std::atomic<uint64_t> generation;
+		};
+
+		std::atomic<bool> traceEnabled(false);
+		std::atomic<uint64_t> traceEventCount(65536);
+		std::atomic<uint64_t> traceGeneration(0);
+		const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+		std::mutex threadBuffersMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+		thread_local ThreadBuffer* threadBuffer = nullptr;
+		thread_local std::string threadName;
+
+		ThreadBuffer* getThreadBuffer()
+		{
+			// Registering happens once per thread, on its first event recorded
+
+			if (!threadBuffer)
+			{
+				std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+				buffer->events.resize(std::bit_ceil(traceEventCount.load(std::memory_order_relaxed)));
+				buffer->writeIndex.store(0, std::memory_order_relaxed);
+				buffer->generation.store(traceGeneration.load(std::memory_order_acquire), std::memory_order_relaxed);
+
+				std::lock_guard lock(threadBuffersMutex);
+				buffer->threadIndex = threadBuffers.size();
+				buffer->threadName = threadName.empty() ? "Thread " + std::to_string(buffer->threadIndex) : threadName;
+				threadBuffer = buffer.get();
+				threadBuffers.push_back(std::move(buffer));
+			}
+
+			// Events of a previous generation are dropped, the write index is only ever written by its thread
+
+			const uint64_t generation = traceGeneration.load(std::memory_order_acquire);
+			if (threadBuffer->generation.load(std::memory_order_relaxed) != generation)
+			{
+				const uint64_t eventCount = std::bit_ceil(traceEventCount.load(std::memory_order_relaxed));
+				if (threadBuffer->events.size() != eventCount)
+				{
+					std::lock_guard lock(threadBuffersMutex);
+					threadBuffer->events.resize(eventCount);
+				}
+
+				threadBuffer->writeIndex.store(0, std::memory_order_relaxed);
+				threadBuffer->generation.store(generation, std::memory_order_release);
+			}
+
+			return threadBuffer;
+		}
+
+		// Copy the events still in the ring, dropping those that may have been overwritten while copying
+
+		std::vector<TraceEvent> readEvents(const ThreadBuffer& buffer)
+		{
+			// A ring not reset since the last clear holds nothing of the current generation
+
+			if (buffer.generation.load(std::memory_order_acquire) != traceGeneration.load(std::memory_order_acquire))
+			{
+				return {};
+			}
+
+			const uint64_t capacity = buffer.events.size();
+			const uint64_t writeIndexBefore = buffer.writeIndex.load(std::memory_order_acquire);
+
+			std::vector<TraceEvent> events;
+			const uint64_t first = writeIndexBefore > capacity ? writeIndexBefore - capacity : 0;
+			for (uint64_t i = first; i < writeIndexBefore; ++i)
+			{
+				events.push_back(buffer.events[i & (capacity - 1)]);
+			}
+
+			const uint64_t writeIndexAfter = buffer.writeIndex.load(std::memory_order_acquire);
+			const uint64_t overwritten = writeIndexAfter > capacity + first ? writeIndexAfter - capacity - first : 0;
+			events.erase(events.begin(), events.begin() + std::min<uint64_t>(overwritten, events.size()));
+
+			return events;
+		}
+
+		std::string escapeJson(const std::string& str)
+		{
+			std::string result;
+			for (char c : str)
+			{
+				if (c == '"' || c == '\\')
+				{
+					result.push_back('\\');
+				}
+				result.push_back(c);
+			}
+
+			return result;
+		}
+
+		// Minimal protobuf encoding, enough for the few Perfetto messages used
+
+		void writeVarint(std::string& message, uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				message.push_back(static_cast<char>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+			message.push_back(static_cast<char>(value));
+		}
+
+		void writeVarintField(std::string& message, uint32_t field, uint64_t value)
+		{
+			writeVarint(message, field << 3);
+			writeVarint(message, value);
+		}
+
+		void writeBytesField(std::string& message, uint32_t field, const std::string& bytes)
+		{
+			writeVarint(message, (field << 3) | 2);
+			writeVarint(message, bytes.size());
+			message.append(bytes);
+		}
+	}
+
+	void Trace::enable(uint64_t eventCountPerThread)
+	{
+		assert(eventCountPerThread > 0);
+
+		// Rings of another size are reallocated by their thread, on its next event
+
+		if (traceEventCount.exchange(eventCountPerThread, std::memory_order_relaxed) != eventCountPerThread)
+		{
+			traceGeneration.fetch_add(1, std::memory_order_release);
+		}
+		traceEnabled.store(true, std::memory_order_relaxed);
+	}
+
+	void Trace::disable()
+	{
+		traceEnabled.store(false, std::memory_order_relaxed);
+	}
+
+	bool Trace::isEnabled()
+	{
+		return traceEnabled.load(std::memory_order_relaxed);
+	}
+
+	void Trace::clear()
+	{
+		traceGeneration.fetch_add(1, std::memory_order_release);
+	}
+
+	void Trace::setThreadName(const std::string& name)
+	{
+		// Only the name is kept until the thread records an event, threads that never do have no ring
+
+		threadName = name;
+		if (threadBuffer)
+		{
+			std::lock_guard lock(threadBuffersMutex);
+			threadBuffer->threadName = name;
+		}
+	}
+
+	bool Trace::writeChromeTrace(const std::filesystem::path& path)
+	{
+		std::ofstream stream(path);
+		if (!stream)
+		{
+			return false;
+		}
+
+		std::lock_guard lock(threadBuffersMutex);
+
+		// Times are in microseconds, written with a fixed nanosecond fraction so that they keep their resolution
+		// however long the process runs
+
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+		bool first = true;
+		for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+		{
+			stream << (first ? "\n" : ",\n");
+			stream << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadIndex;
+			stream << ", \"args\": {\"name\": \"" << escapeJson(buffer->threadName) << "\"}}";
+			first = false;
+
+			for (const TraceEvent& event : readEvents(*buffer))
+			{
+				stream << ",\n{\"name\": \"" << escapeJson(event.name) << "\", \"cat\": \"crozet\", \"ph\": \"X\", \"pid\": 1";
+				stream << ", \"tid\": " << buffer->threadIndex << ", \"ts\": " << event.start * 1e-3 << ", \"dur\": " << (event.end - event.start) * 1e-3;
+				stream << ", \"args\": {\"id\": " << event.id << "}}";
+			}
+		}
+
+		stream << "\n]}\n";
+
+		return static_cast<bool>(stream);
+	}
+
+	bool Trace::writePerfettoTrace(const std::filesystem::path& path)
+	{
+		std::ofstream stream(path, std::ios::binary);
+		if (!stream)
+		{
+			return false;
+		}
+
+		std::lock_guard lock(threadBuffersMutex);
+
+		std::string trace;
+		const auto addPacket = [&](const std::string& packet)
+		{
+			writeBytesField(trace, 1, packet);
+		};
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+		{
+			const uint64_t trackUuid = buffer->threadIndex + 1;
+			const uint32_t sequenceId = buffer->threadIndex + 1;
+
+			// One track per thread, described once at the beginning of its sequence
+
+			std::string threadDescriptor;
+			writeVarintField(threadDescriptor, 1, 1);
+			writeVarintField(threadDescriptor, 2, buffer->threadIndex + 1);
+			writeBytesField(threadDescriptor, 5, buffer->threadName);
+
+			std::string trackDescriptor;
+			writeVarintField(trackDescriptor, 1, trackUuid);
+			writeBytesField(trackDescriptor, 2, buffer->threadName);
+			writeBytesField(trackDescriptor, 4, threadDescriptor);
+
+			std::string descriptorPacket;
+			writeVarintField(descriptorPacket, 10, sequenceId);
+			writeVarintField(descriptorPacket, 13, 1);
+			writeBytesField(descriptorPacket, 60, trackDescriptor);
+			addPacket(descriptorPacket);
+
+			// Spans are stored when they end, split them in begin and end events sorted so that they nest properly
+
+			struct SliceEvent
+			{
+				uint64_t time;
+				uint64_t duration;
+				bool begin;
+				const TraceEvent* event;
+			};
+
+			const std::vector<TraceEvent> events = readEvents(*buffer);
+			std::vector<SliceEvent> sliceEvents;
+			for (const TraceEvent& event : events)
+			{
+				sliceEvents.push_back({ event.start, event.end - event.start, true, &event });
+				sliceEvents.push_back({ event.end, event.end - event.start, false, &event });
+			}
+
+			std::sort(sliceEvents.begin(), sliceEvents.end(), [](const SliceEvent& a, const SliceEvent& b)
+			{
+				if (a.time != b.time)
+				{
+					return a.time < b.time;
+				}
+				else if (a.begin != b.begin)
+				{
+					return !a.begin;
+				}
+				else
+				{
+					return a.begin ? a.duration > b.duration : a.duration < b.duration;
+				}
+			});
+
+			for (const SliceEvent& sliceEvent : sliceEvents)
+			{
+				std::string trackEvent;
+				writeVarintField(trackEvent, 9, sliceEvent.begin ? 1 : 2);
+				writeVarintField(trackEvent, 11, trackUuid);
+
+				if (sliceEvent.begin)
+				{
+					std::string annotation;
+					writeBytesField(annotation, 10, "id");
+					writeVarintField(annotation, 3, sliceEvent.event->id);
+
+					writeBytesField(trackEvent, 23, sliceEvent.event->name);
+					writeBytesField(trackEvent, 4, annotation);
+				}
+
+				std::string packet;
+				writeVarintField(packet, 8, sliceEvent.time);
+				writeVarintField(packet, 10, sequenceId);
+				writeBytesField(packet, 11, trackEvent);
+				addPacket(packet);
+			}
+		}
+
+		stream.write(trace.data(), trace.size());
+
+		return static_cast<bool>(stream);
+	}
+
+	uint64_t Trace::getTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+	}
+
+	void Trace::addEvent(const char* name, uint64_t id, uint64_t start, uint64_t end)
+	{
+		ThreadBuffer* buffer = getThreadBuffer();
+
+		const uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+		buffer->events[index & (buffer->events.size() - 1)] = { name, id, start, end };
+		buffer->writeIndex.store(index + 1, std::memory_order_release);
+	}
+
+	TraceSpan::TraceSpan(const char* name, uint64_t id) :
+		_name(name),
+		_id(id),
+		_start(UINT64_MAX)
+	{
+		// When tracing is disabled a span costs a relaxed load here and a comparison in the destructor
+
+		if (traceEnabled.load(std::memory_order_relaxed))
+		{
+			_start = Trace::getTime();
+		}
+	}
+
+	TraceSpan::~TraceSpan()
+	{
+		if (_start != UINT64_MAX)
+		{
+			Trace::addEvent(_name, _id, _start, Trace::getTime());
+		}
+	}
+}